@@ -0,0 +1,208 @@
+#ifndef SYNCHROTRONARENA_HPP
+#define SYNCHROTRONARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	Arena hands out memory from large slabs, which are only returned to the heap
+	 *	all at once by release() (or the destructor).
+	 *
+	 *	Small blocks (up to MAX_SMALL bytes) that are deallocated are kept in a free list
+	 *	per 16 byte size class and reused, so adding and removing connections doesn't grow the arena.
+	 *	Larger blocks are only reclaimed by release().
+	 *
+	 *	Not thread safe: a netlist should be built from a single thread, or under a lock.
+	 */
+	class Arena {
+		private:
+			static const size_t ALIGNMENT  = 16;
+			static const size_t MAX_SMALL  = 512;
+			static const size_t SLAB_SIZE  = 256 * 1024;
+
+			struct FreeBlock {
+				FreeBlock* next;
+			};
+
+			/**	\brief
+			 *	Every slab allocated from the heap.
+			 */
+			std::vector<std::unique_ptr<char[]>> slabs;
+
+			/**	\brief
+			 *	The unused part of the current slab.
+			 */
+			char*	m_current;
+			size_t	m_left;
+
+			/**	\brief
+			 *	Free list per size class of ALIGNMENT bytes.
+			 */
+			FreeBlock* m_free[MAX_SMALL / ALIGNMENT + 1];
+
+			size_t	m_reserved;
+			size_t	m_used;
+
+			static inline size_t roundUp(size_t bytes) {
+				return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+			}
+
+		public:
+			Arena() : m_current(nullptr), m_left(0), m_reserved(0), m_used(0) {
+				for(auto& f : this->m_free) f = nullptr;
+			}
+
+			Arena(const Arena&) = delete;
+			Arena& operator=(const Arena&) = delete;
+
+			/**	\brief	Allocates bytes, aligned to 16 bytes.
+			 *
+			 *	\return	void*
+			 *		Returns the memory, valid until it is deallocated or the arena is released.
+			 */
+			void* allocate(size_t bytes) {
+				bytes = roundUp(bytes ? bytes : 1);
+
+				if (bytes <= MAX_SMALL) {
+					FreeBlock*& head = this->m_free[bytes / ALIGNMENT];
+
+					if (head) {
+						FreeBlock* block = head;
+						head = block->next;
+						this->m_used += bytes;
+						return block;
+					}
+				}
+
+				if (bytes > this->m_left) {
+					const size_t size = bytes > SLAB_SIZE / 4 ? bytes : SLAB_SIZE;
+
+					// new char[] is aligned for any fundamental type, round up to ALIGNMENT for the rest
+					this->slabs.emplace_back(new char[size + ALIGNMENT]);
+					this->m_reserved += size + ALIGNMENT;
+
+					const uintptr_t base = reinterpret_cast<uintptr_t>(this->slabs.back().get());
+					char* aligned = reinterpret_cast<char*>((base + ALIGNMENT - 1) & ~uintptr_t(ALIGNMENT - 1));
+
+					if (size != SLAB_SIZE) {
+						// Dedicated slab for a large block, keep using the current one for the rest
+						this->m_used += bytes;
+						return aligned;
+					}
+
+					this->m_current = aligned;
+					this->m_left    = size;
+				}
+
+				void* p = this->m_current;
+				this->m_current += bytes;
+				this->m_left    -= bytes;
+				this->m_used    += bytes;
+
+				return p;
+			}
+
+			/**	\brief	Returns a block of bytes to the arena, small blocks are reused by the next allocate().
+			 */
+			void deallocate(void* p, size_t bytes) {
+				if (!p) return;
+
+				bytes = roundUp(bytes ? bytes : 1);
+				this->m_used -= bytes;
+
+				if (bytes <= MAX_SMALL) {
+					FreeBlock* block = static_cast<FreeBlock*>(p);
+					block->next = this->m_free[bytes / ALIGNMENT];
+					this->m_free[bytes / ALIGNMENT] = block;
+				}
+			}
+
+			/**	\brief	Returns every slab to the heap in one go.
+			 *
+			 *		Everything allocated from this arena becomes invalid, without running any destructor.
+			 */
+			void release() {
+				this->slabs.clear();
+				this->m_current  = nullptr;
+				this->m_left     = 0;
+				this->m_reserved = 0;
+				this->m_used     = 0;
+
+				for(auto& f : this->m_free) f = nullptr;
+			}
+
+			/**	\brief	Gets the amount of bytes taken from the heap.
+			 */
+			inline size_t getReservedBytes() const {
+				return this->m_reserved;
+			}
+
+			/**	\brief	Gets the amount of bytes currently handed out (rounded up to 16 bytes per block).
+			 */
+			inline size_t getUsedBytes() const {
+				return this->m_used;
+			}
+	};
+
+	/** \brief
+	 *	ArenaAllocator is a std compatible allocator that allocates from an Arena.
+	 *
+	 *	A default constructed ArenaAllocator has no Arena and uses the heap instead,
+	 *	so Components that aren't created through a Netlist still work.
+	 *
+	 *	\param	T
+	 *		The type to allocate.
+	 */
+	template <class T>
+	class ArenaAllocator {
+		private:
+			template <class U> friend class ArenaAllocator;
+
+			Arena* m_arena;
+
+		public:
+			typedef T			value_type;
+			typedef T*			pointer;
+			typedef const T*	const_pointer;
+			typedef T&			reference;
+			typedef const T&	const_reference;
+			typedef size_t		size_type;
+			typedef ptrdiff_t	difference_type;
+
+			template <class U> struct rebind { typedef ArenaAllocator<U> other; };
+
+			ArenaAllocator() : m_arena(nullptr)											{}
+			ArenaAllocator(Arena* arena) : m_arena(arena)								{}
+			template <class U> ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.m_arena)	{}
+
+			inline Arena* getArena() const												{ return this->m_arena;	}
+
+			T* allocate(size_t n) {
+				if (!this->m_arena)
+					return static_cast<T*>(::operator new(n * sizeof(T)));
+
+				return static_cast<T*>(this->m_arena->allocate(n * sizeof(T)));
+			}
+
+			void deallocate(T* p, size_t n) {
+				if (!this->m_arena) {
+					::operator delete(p);
+					return;
+				}
+
+				this->m_arena->deallocate(p, n * sizeof(T));
+			}
+
+			template <class U>
+			inline bool operator==(const ArenaAllocator<U>& other) const				{ return this->m_arena == other.m_arena;	}
+			template <class U>
+			inline bool operator!=(const ArenaAllocator<U>& other) const				{ return this->m_arena != other.m_arena;	}
+	};
+}
+
+#endif // SYNCHROTRONARENA_HPP
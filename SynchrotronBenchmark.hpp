@@ -0,0 +1,275 @@
+#ifndef SYNCHROTRONBENCHMARK_HPP
+#define SYNCHROTRONBENCHMARK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Synchrotron {
+namespace Benchmark {
+
+	/**	\brief	Gets a monotonic timestamp in nanoseconds.
+	 */
+	inline uint64_t now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/** \brief
+	 *	The command line of a benchmark binary:
+	 *
+	 *		benchmark [name...] [--warmup N] [--repetitions N] [--min-elements N] [--max-elements N]
+	 *		          [--max-linear-elements N] [--json FILE]
+	 *
+	 *	Without names every benchmark runs. Element counts scale in powers of 10 from --min-elements to --max-elements,
+	 *	--max-linear-elements caps them for containers that remove in O(n), which are quadratic to tear down.
+	 */
+	struct Options {
+		size_t						warmup;
+		size_t						repetitions;
+		size_t						minElements;
+		size_t						maxElements;
+		size_t						maxLinearElements;
+		std::string					json;
+		std::vector<std::string>	names;
+
+		Options() : warmup(2), repetitions(100), minElements(100), maxElements(100000), maxLinearElements(10000) {}
+
+		/**	\brief	Parses argv into these options.
+		 *
+		 *	\return	bool
+		 *		Returns false (after printing why) on an unknown option or a missing value.
+		 */
+		bool parse(int argc, char** argv) {
+			for (int i = 1; i < argc; i++) {
+				const char* arg = argv[i];
+
+				if (strncmp(arg, "--", 2) != 0) {
+					this->names.push_back(arg);
+					continue;
+				}
+
+				if (i + 1 >= argc) {
+					fprintf(stderr, "Missing value for %s\n", arg);
+					return false;
+				}
+
+				const char* value = argv[++i];
+
+				if		(strcmp(arg, "--warmup") == 0)			this->warmup		= strtoull(value, nullptr, 10);
+				else if (strcmp(arg, "--repetitions") == 0)		this->repetitions	= std::max<size_t>(1, strtoull(value, nullptr, 10));
+				else if (strcmp(arg, "--min-elements") == 0)	this->minElements	= std::max<size_t>(1, strtoull(value, nullptr, 10));
+				else if (strcmp(arg, "--max-elements") == 0)	this->maxElements	= strtoull(value, nullptr, 10);
+				else if (strcmp(arg, "--max-linear-elements") == 0)	this->maxLinearElements = strtoull(value, nullptr, 10);
+				else if (strcmp(arg, "--json") == 0)			this->json			= value;
+				else {
+					fprintf(stderr, "Unknown option %s\n", arg);
+					return false;
+				}
+			}
+
+			return true;
+		}
+	};
+
+	/** \brief
+	 *	Order statistics of a set of runtimes, in nanoseconds.
+	 */
+	struct Stats {
+		size_t		samples;
+		uint64_t	min, median, p99, max;
+		double		mean;
+
+		Stats() : samples(0), min(0), median(0), p99(0), max(0), mean(0) {}
+
+		static Stats of(std::vector<uint64_t> runtimes) {
+			Stats s;
+
+			if (runtimes.empty())
+				return s;
+
+			std::sort(runtimes.begin(), runtimes.end());
+
+			double sum = 0;
+			for (auto r : runtimes) sum += r;
+
+			s.samples = runtimes.size();
+			s.min	  = runtimes.front();
+			s.max	  = runtimes.back();
+			s.median  = runtimes[(runtimes.size() - 1) / 2];
+			s.p99	  = runtimes[std::min(runtimes.size() - 1, (runtimes.size() * 99 + 99) / 100 - 1)];
+			s.mean	  = sum / runtimes.size();
+
+			return s;
+		}
+	};
+
+	/** \brief
+	 *	One measured series: a benchmark, optionally on a variant and an amount of elements.
+	 */
+	struct Result {
+		std::string	name;
+		std::string	variant;
+		size_t		elements;
+		Stats		stats;
+	};
+
+	/** \brief
+	 *	Suite runs and records measurements, prints them as they come in and writes them as JSON at the end.
+	 *	Every series reports its median and 99th percentile, which unlike the average aren't skewed by a few preempted runs.
+	 */
+	class Suite {
+		private:
+			Options				options;
+			std::vector<Result>	results;
+
+			static void writeString(FILE* out, const std::string& s) {
+				fputc('"', out);
+
+				for (char c : s) {
+					if (c == '"' || c == '\\') fputc('\\', out);
+					fputc(c, out);
+				}
+
+				fputc('"', out);
+			}
+
+		public:
+			explicit Suite(const Options& options) : options(options) {}
+
+			inline const Options& getOptions() const {
+				return this->options;
+			}
+
+			inline const std::vector<Result>& getResults() const {
+				return this->results;
+			}
+
+			/**	\brief	Whether the benchmark called name should run.
+			 */
+			bool selected(const char* name) const {
+				if (this->options.names.empty())
+					return true;
+
+				return std::find(this->options.names.begin(), this->options.names.end(), name) != this->options.names.end();
+			}
+
+			/**	\brief	Gets the element counts to scale over: powers of 10 from minElements up to maxElements.
+			 *
+			 *	\param	linear
+			 *		Whether to stop at maxLinearElements instead.
+			 */
+			std::vector<size_t> sizes(bool linear = false) const {
+				std::vector<size_t> counts;
+				const size_t max = linear ? std::min(this->options.maxElements, this->options.maxLinearElements) : this->options.maxElements;
+
+				for (size_t n = this->options.minElements; n <= max; n *= 10) {
+					counts.push_back(n);
+					if (n > max / 10) break;
+				}
+
+				return counts;
+			}
+
+			/**	\brief	Records and prints a series of runtimes.
+			 *
+			 *	\param	name
+			 *		What was measured.
+			 *	\param	variant
+			 *		The variant it was measured on, may be empty.
+			 *	\param	elements
+			 *		The amount of elements it was measured with, 0 if it doesn't apply.
+			 *	\param	runtimes
+			 *		The runtimes in nanoseconds.
+			 */
+			const Stats& record(const std::string& name, const std::string& variant, size_t elements, const std::vector<uint64_t>& runtimes) {
+				Result r;
+				r.name		= name;
+				r.variant	= variant;
+				r.elements	= elements;
+				r.stats		= Stats::of(runtimes);
+
+				this->results.push_back(r);
+
+				std::string label = variant.empty() ? name : variant + " " + name;
+				if (elements) label += " [" + std::to_string(elements) + "]";
+
+				printf("%-44s :: median %12llu ns :: p99 %12llu ns :: (min= %12llu, max= %12llu)\n", label.c_str(),
+					   (unsigned long long) r.stats.median, (unsigned long long) r.stats.p99,
+					   (unsigned long long) r.stats.min, (unsigned long long) r.stats.max);
+
+				return this->results.back().stats;
+			}
+
+			/**	\brief	Runs setup(i) and f(i), first --warmup times untimed, then times times timed.
+			 *
+			 *	\param	times
+			 *		The amount of timed runs, at least 1.
+			 *
+			 *	\return	std::vector<uint64_t>
+			 *		Returns the runtimes of f in nanoseconds, for record().
+			 */
+			template <class S, class F>
+			std::vector<uint64_t> run(size_t times, S setup, F f) const {
+				std::vector<uint64_t> runtimes;
+
+				times = std::max<size_t>(1, times);
+
+				for (size_t i = 0; i < this->options.warmup + times; i++) {
+					setup(i);
+
+					const uint64_t t1 = now();
+					f(i);
+					const uint64_t t2 = now();
+
+					if (i >= this->options.warmup)
+						runtimes.push_back(t2 - t1);
+				}
+
+				return runtimes;
+			}
+
+			/**	\brief	Writes every recorded result to the --json file, if there is one.
+			 *
+			 *	\return	bool
+			 *		Returns false if the file couldn't be written.
+			 */
+			bool writeJson() const {
+				if (this->options.json.empty())
+					return true;
+
+				FILE* out = fopen(this->options.json.c_str(), "w");
+
+				if (!out) {
+					fprintf(stderr, "Can't write %s\n", this->options.json.c_str());
+					return false;
+				}
+
+				fprintf(out, "{\n  \"warmup\": %zu,\n  \"repetitions\": %zu,\n  \"results\": [", this->options.warmup, this->options.repetitions);
+
+				for (size_t i = 0; i < this->results.size(); i++) {
+					const Result& r = this->results[i];
+
+					fprintf(out, "%s\n    {\"name\": ", i ? "," : "");
+					writeString(out, r.name);
+					fprintf(out, ", \"variant\": ");
+					writeString(out, r.variant);
+					fprintf(out, ", \"elements\": %zu, \"samples\": %zu, \"min_ns\": %llu, \"median_ns\": %llu, \"p99_ns\": %llu, \"max_ns\": %llu, \"mean_ns\": %.1f}",
+							r.elements, r.stats.samples, (unsigned long long) r.stats.min, (unsigned long long) r.stats.median,
+							(unsigned long long) r.stats.p99, (unsigned long long) r.stats.max, r.stats.mean);
+				}
+
+				fprintf(out, "\n  ]\n}\n");
+
+				return fclose(out) == 0;
+			}
+	};
+}
+}
+
+#endif // SYNCHROTRONBENCHMARK_HPP
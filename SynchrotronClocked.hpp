@@ -0,0 +1,208 @@
+#ifndef SYNCHROTRONCLOCKED_HPP
+#define SYNCHROTRONCLOCKED_HPP
+
+#include "SynchrotronGraph.hpp"
+#include "SynchrotronThreadPool.hpp"
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	ClockedNetlist runs a connected graph of Components synchronously: every clock step() is two phases.
+	 *
+	 *	*	compute: every Component evaluate()s its next state from the current states of its inputs,
+	 *		into a separate buffer, so no Component sees a state of the same step.
+	 *	*	commit: every next state is applied with setState() at once.
+	 *
+	 *	Unlike tick() and emit(), which overwrite the state in place and propagate right away,
+	 *	the result doesn't depend on the order the Components or their outputs are visited in:
+	 *	a step behaves like every Component being a register on the same clock edge.
+	 *	So it gives the same results for every variant, whatever order their connection_container has,
+	 *	cycles (e.g. ring counters) are fine, and both phases can run in parallel (see step(ThreadPool&)).
+	 *
+	 *	Only `getInputs()`, `getOutputs()`, `evaluate()`, `getState()` and `setState()` are used,
+	 *	so derived classes that re-implement evaluate() are honoured.
+	 *	Changing the topology of the graph requires another compile().
+	 *
+	 *	\param	Component
+	 *		The SynchrotronComponent type of the graph.
+	 */
+	template <class Component>
+	class ClockedNetlist {
+		public:
+			typedef typename std::decay<decltype(std::declval<const Component&>().getState())>::type state_type;
+
+		private:
+			/**	\brief
+			 *	Every Component in the graph, in breadth first order.
+			 */
+			std::vector<Component*> components;
+
+			/**	\brief
+			 *	The state a Component takes on the commit, and whether it differs from the current one.
+			 */
+			struct Next {
+				state_type	state;
+				bool		changed;
+			};
+
+			/**	\brief
+			 *	The next state of every Component, same order as components.
+			 */
+			std::vector<Next> next;
+
+			/**	\brief	Computes the next state of components[first .. last].
+			 */
+			void compute(size_t first, size_t last) {
+				for(size_t i = first; i < last; i++) {
+					this->next[i].state   = this->components[i]->evaluate();
+					this->next[i].changed = this->next[i].state != this->components[i]->getState();
+				}
+			}
+
+			/**	\brief	Applies the next state of components[first .. last].
+			 */
+			void commit(size_t first, size_t last) {
+				for(size_t i = first; i < last; i++) {
+					if (this->next[i].changed)
+						this->components[i]->setState(this->next[i].state);
+				}
+			}
+
+			bool anyChanged() const {
+				for(auto& n : this->next) {
+					if (n.changed) return true;
+				}
+
+				return false;
+			}
+
+		public:
+			/** \brief	Default constructor, compile() still has to be called.
+			 */
+			ClockedNetlist() {}
+
+			/** \brief	Compiles the graph connected to the Components in list.
+			 *
+			 *	\param	list
+			 *		Any of the Components in the graph(s) to clock.
+			 */
+			ClockedNetlist(std::initializer_list<Component*> list) {
+				this->compile(list.begin(), list.end());
+			}
+
+			/** \brief	Compiles the graph connected to the Components in [first, last).
+			 *
+			 *	\param	first, last
+			 *		A range of Component* from the graph(s) to clock.
+			 */
+			template <class InputIt>
+			ClockedNetlist(InputIt first, InputIt last) {
+				this->compile(first, last);
+			}
+
+			/**	\brief	(Re)collects the Components of the graph connected to [first, last).
+			 *
+			 *	\param	first, last
+			 *		A range of Component* from the graph(s) to clock.
+			 */
+			template <class InputIt>
+			void compile(InputIt first, InputIt last) {
+				this->components = collectComponents<Component>(first, last);
+				this->next.assign(this->components.size(), Next());
+			}
+
+			/**	\brief	Gets the Components in the graph.
+			 *
+			 *	\return	std::vector<Component*>&
+			 *		Returns a reference to every Component.
+			 */
+			const std::vector<Component*>& getComponents() const {
+				return this->components;
+			}
+
+			/**	\brief	Runs one clock step: computes the next state of every Component, then commits all of them.
+			 *
+			 *	\return	bool
+			 *		Returns whether any state changed.
+			 */
+			bool step() {
+				this->compute(0, this->components.size());
+				this->commit(0, this->components.size());
+
+				return this->anyChanged();
+			}
+
+			/**	\brief	Runs one clock step, both phases in parallel on pool.
+			 *
+			 *		Between the phases is a barrier, so no Component is committed while another one still computes.
+			 *
+			 *	\param	pool
+			 *		The threads to run on.
+			 *	\param	lines_per_chunk
+			 *		The amount of cache lines of next states per chunk, chunks never share a line.
+			 *
+			 *	\return	bool
+			 *		Returns whether any state changed.
+			 */
+			bool step(ThreadPool& pool, size_t lines_per_chunk = 16) {
+				pool.parallelForLines(this->next.data(), 0, this->components.size(), lines_per_chunk,
+									  [this](size_t first, size_t last) { this->compute(first, last); });
+
+				pool.parallelForLines(this->next.data(), 0, this->components.size(), lines_per_chunk,
+									  [this](size_t first, size_t last) { this->commit(first, last); });
+
+				return this->anyChanged();
+			}
+
+			/**	\brief	Runs clock steps until no state changes anymore.
+			 *
+			 *	\param	limit
+			 *		The maximum amount of steps, 0 means no limit.
+			 *		A graph with feedback (e.g. a ring counter) may never settle without one.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of steps that were run, including the last one that changed nothing.
+			 */
+			size_t run(size_t limit = 0) {
+				size_t steps = 0;
+
+				while (limit == 0 || steps < limit) {
+					++steps;
+
+					if (!this->step())
+						break;
+				}
+
+				return steps;
+			}
+
+			/**	\brief	Runs clock steps on pool until no state changes anymore.
+			 *
+			 *	\param	pool
+			 *		The threads to run on.
+			 *	\param	limit
+			 *		The maximum amount of steps, 0 means no limit.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of steps that were run, including the last one that changed nothing.
+			 */
+			size_t run(ThreadPool& pool, size_t limit = 0) {
+				size_t steps = 0;
+
+				while (limit == 0 || steps < limit) {
+					++steps;
+
+					if (!this->step(pool))
+						break;
+				}
+
+				return steps;
+			}
+	};
+}
+
+#endif // SYNCHROTRONCLOCKED_HPP
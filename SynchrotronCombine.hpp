@@ -0,0 +1,288 @@
+#ifndef SYNCHROTRONCOMBINE_HPP
+#define SYNCHROTRONCOMBINE_HPP
+
+#include "SynchrotronSimd.hpp"
+#include <bitset>
+#include <type_traits>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	Combine policies decide how a SynchrotronComponent reduces the states of its inputs
+	 *	into its own state, as a template argument so the compiler can inline the reduction.
+	 *
+	 *	FoldPolicy implements `reduce()` as a fold for a Derived policy, which should offer:
+	 *	*	`identity<N>()`			The identity element of combine().
+	 *	*	`saturation<N>()`		The absorbing value, the fold stops early once it is reached.
+	 *	*	`saturates`				Whether there is such an absorbing value.
+	 *	*	`combine(acc, in)`		Combines one input into the accumulator.
+	 *	*	`seed(prev)`			The value to start folding from, given the previous state.
+	 *	*	`finalize(acc)`			Turns the accumulator into the new state.
+	 *	*	`incremental`			Whether a single changed input can be merged with combine()
+	 *								instead of reducing every input (see `Incremental`).
+	 *	*	`word_op`				The bitwise operation combine() is, if any (see SynchrotronSimd.hpp).
+	 *
+	 *	States of SIMD_MIN_BITS or more are reduced with the SIMD word kernels if the policy has a word_op,
+	 *	a batch of inputs at a time, in a single pass over the words of the accumulator.
+	 *	This requires the Getter to return a reference (e.g. getStateRef()), since a copy would cost more than the kernel saves.
+	 *
+	 *	A Component without inputs keeps its state, regardless of the policy.
+	 *
+	 *	\param	Derived
+	 *		The policy that is folded.
+	 */
+	template <class Derived>
+	struct FoldPolicy {
+		template <size_t N>
+		static inline std::bitset<N> seed(const std::bitset<N>&) {
+			return Derived::template identity<N>();
+		}
+
+		template <size_t N>
+		static inline std::bitset<N> finalize(const std::bitset<N>& acc) {
+			return acc;
+		}
+
+		/**	\brief	Merges a single changed input into state, only valid if Derived::incremental.
+		 */
+		template <size_t N>
+		static inline void merge(std::bitset<N>& state, const std::bitset<N>& input) {
+			Derived::combine(state, input);
+		}
+
+		/**	\brief	Reduces the states of [first, last) into the new state.
+		 *
+		 *	\param	prev
+		 *		The current state of the Component.
+		 *	\param	first, last
+		 *		The range of inputs.
+		 *	\param	get
+		 *		Gets the state of an input from *first.
+		 *
+		 *	\return	std::bitset<N>
+		 *		Returns the new state.
+		 */
+		template <size_t N, class InputIt, class Getter>
+		static inline std::bitset<N> reduce(const std::bitset<N>& prev, InputIt first, InputIt last, Getter get) {
+			if (first == last)
+				return prev;
+
+			typedef decltype(get(*first)) input_type;
+
+			return FoldPolicy::fold<N>(prev, first, last, get, std::integral_constant<bool,
+									   SIMD_BITSETS && N >= SIMD_MIN_BITS && Derived::word_op != WORD_NONE &&
+									   std::is_lvalue_reference<input_type>::value>());
+		}
+
+		static const WordOp word_op = WORD_NONE;
+
+	private:
+		/**	\brief	Folds the inputs one by one.
+		 */
+		template <size_t N, class InputIt, class Getter>
+		static inline std::bitset<N> fold(const std::bitset<N>& prev, InputIt first, InputIt last, Getter get, std::false_type) {
+			const std::bitset<N> saturation = Derived::template saturation<N>();
+			std::bitset<N> acc = Derived::seed(prev);
+
+			for(; first != last; ++first) {
+				Derived::combine(acc, get(*first));
+
+				if (Derived::saturates && acc == saturation)
+					break;
+			}
+
+			return Derived::finalize(acc);
+		}
+
+		/**	\brief	Folds the inputs a batch at a time with the word kernel of Derived::word_op.
+		 */
+		template <size_t N, class InputIt, class Getter>
+		static inline std::bitset<N> fold(const std::bitset<N>& prev, InputIt first, InputIt last, Getter get, std::true_type) {
+			const size_t batch_size = 8;
+			const size_t words = sizeof(std::bitset<N>) / sizeof(uint64_t);
+
+			const std::bitset<N> saturation = Derived::template saturation<N>();
+			std::bitset<N> acc = Derived::seed(prev);
+
+			const uint64_t* batch[batch_size];
+			size_t k = 0;
+
+			for(; first != last; ++first) {
+				batch[k++] = bitsetWords(get(*first));
+
+				if (k == batch_size) {
+					reduceWords<Derived::word_op>(bitsetWords(acc), batch, k, words);
+					k = 0;
+
+					if (Derived::saturates && acc == saturation)
+						return Derived::finalize(acc);
+				}
+			}
+
+			if (k)
+				reduceWords<Derived::word_op>(bitsetWords(acc), batch, k, words);
+
+			return Derived::finalize(acc);
+		}
+	};
+
+	/** \brief
+	 *	Bitwise OR of all inputs and the previous state, the default logic.
+	 *	The state only ever gains bits, so a single input can be merged on its own.
+	 */
+	struct OrPolicy : public FoldPolicy<OrPolicy> {
+		static const bool incremental = true;
+		static const bool saturates   = true;
+		static const WordOp word_op   = WORD_OR;
+
+		template <size_t N> static inline std::bitset<N> identity()		{ return std::bitset<N>();			}
+		template <size_t N> static inline std::bitset<N> saturation()	{ return std::bitset<N>().set();	}
+		template <size_t N> static inline std::bitset<N> seed(const std::bitset<N>& prev) { return prev;	}
+
+		template <size_t N>
+		static inline void combine(std::bitset<N>& acc, const std::bitset<N>& in) {
+			acc |= in;
+		}
+	};
+
+	/** \brief
+	 *	Bitwise AND of all inputs.
+	 */
+	struct AndPolicy : public FoldPolicy<AndPolicy> {
+		static const bool incremental = false;
+		static const bool saturates   = true;
+		static const WordOp word_op   = WORD_AND;
+
+		template <size_t N> static inline std::bitset<N> identity()		{ return std::bitset<N>().set();	}
+		template <size_t N> static inline std::bitset<N> saturation()	{ return std::bitset<N>();			}
+
+		template <size_t N>
+		static inline void combine(std::bitset<N>& acc, const std::bitset<N>& in) {
+			acc &= in;
+		}
+	};
+
+	/** \brief
+	 *	Bitwise NAND of all inputs, an AND that is inverted when finalized.
+	 */
+	struct NandPolicy : public FoldPolicy<NandPolicy> {
+		static const bool incremental = false;
+		static const bool saturates   = true;
+		static const WordOp word_op   = WORD_AND;
+
+		template <size_t N> static inline std::bitset<N> identity()		{ return std::bitset<N>().set();	}
+		template <size_t N> static inline std::bitset<N> saturation()	{ return std::bitset<N>();			}
+		template <size_t N> static inline std::bitset<N> finalize(const std::bitset<N>& acc) { return ~acc;	}
+
+		template <size_t N>
+		static inline void combine(std::bitset<N>& acc, const std::bitset<N>& in) {
+			acc &= in;
+		}
+	};
+
+	/** \brief
+	 *	Bitwise XOR of all inputs, never saturates.
+	 */
+	struct XorPolicy : public FoldPolicy<XorPolicy> {
+		static const bool incremental = false;
+		static const bool saturates   = false;
+		static const WordOp word_op   = WORD_XOR;
+
+		template <size_t N> static inline std::bitset<N> identity()		{ return std::bitset<N>();			}
+		template <size_t N> static inline std::bitset<N> saturation()	{ return std::bitset<N>();			}
+
+		template <size_t N>
+		static inline void combine(std::bitset<N>& acc, const std::bitset<N>& in) {
+			acc ^= in;
+		}
+	};
+
+	/** \brief
+	 *	Bitwise majority: a bit is set if it is set in more than half of the inputs.
+	 *
+	 *	This can't be folded into a single bitset, instead every input is added to
+	 *	bit-sliced counters (one bitset per bit of the count), so every step is still a whole-bitset operation.
+	 */
+	struct MajorityPolicy {
+		static const bool incremental = false;
+		static const bool saturates   = false;
+
+		template <size_t N> static inline std::bitset<N> identity()		{ return std::bitset<N>();			}
+		template <size_t N> static inline std::bitset<N> saturation()	{ return std::bitset<N>();			}
+
+		/**	\brief	Never used, the majority can't merge a single input (see `incremental`).
+		 */
+		template <size_t N>
+		static inline void merge(std::bitset<N>&, const std::bitset<N>&) {}
+
+		template <size_t N, class InputIt, class Getter>
+		static inline std::bitset<N> reduce(const std::bitset<N>& prev, InputIt first, InputIt last, Getter get) {
+			if (first == last)
+				return prev;
+
+			std::vector<std::bitset<N>> counters;
+			size_t inputs = 0;
+
+			for(; first != last; ++first, ++inputs) {
+				// Ripple-carry add the input to the counters
+				std::bitset<N> carry = get(*first);
+
+				for(size_t b = 0; carry.any(); b++) {
+					if (b == counters.size())
+						counters.push_back(std::bitset<N>());
+
+					const std::bitset<N> next = counters[b] & carry;
+					counters[b] ^= carry;
+					carry = next;
+				}
+			}
+
+			// Bitwise counters >= inputs / 2 + 1, from the most significant counter down
+			const size_t threshold = inputs / 2 + 1;
+			std::bitset<N> greater, equal;
+			equal.set();
+
+			if (threshold >> counters.size())
+				return greater;
+
+			for(size_t b = counters.size(); b--;) {
+				if ((threshold >> b) & 1) {
+					equal &= counters[b];
+				} else {
+					greater |= equal & counters[b];
+					equal &= ~counters[b];
+				}
+			}
+
+			return greater | equal;
+		}
+	};
+
+	/** \brief
+	 *	Incremental opts one of the SynchrotronComponent variants into merging only the input that emitted,
+	 *	at O(1) instead of O(fan-in) per input event: tick(source) calls `tickMerge(source)` instead of tick().
+	 *
+	 *	Only for a variant itself, since a gate re-implementing tick() or evaluate() would be bypassed,
+	 *	and it is final so nothing can re-implement them after it. The result only matches tick() as long as
+	 *	the state already holds every input, i.e. it was tick()ed since they were connected:
+	 *	with inputs 01 and 10 and a state of 00, an emit() of the second one gives 10 where tick() gives 11.
+	 *
+	 *	\param	Component
+	 *		The variant, its CombinePolicy should be incremental (e.g. OrPolicy).
+	 */
+	template <class Component>
+	class Incremental final : public Component {
+		static_assert(Component::combine_policy::incremental, "Incremental requires an incremental CombinePolicy");
+
+		public:
+			using Component::Component;
+			using Component::tick;
+
+			virtual void tick(Component& source) override {
+				this->tickMerge(source);
+			}
+	};
+}
+
+#endif // SYNCHROTRONCOMBINE_HPP
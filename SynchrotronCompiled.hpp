@@ -0,0 +1,272 @@
+#ifndef SYNCHROTRONCOMPILED_HPP
+#define SYNCHROTRONCOMPILED_HPP
+
+#include "SynchrotronGraph.hpp"
+#include "SynchrotronScheduler.hpp"
+#include "SynchrotronThreadPool.hpp"
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	CompiledNetlist is a levelized snapshot of a connected graph of Components.
+	 *
+	 *	compile() topologically sorts the graph into levels and lays out the states and
+	 *	the input connections of every Component in contiguous arrays, in level order.
+	 *	evaluate() then walks those arrays once, evaluating every Component exactly once per cycle,
+	 *	instead of once for every input that changed.
+	 *
+	 *	Graphs that contain a cycle can't be levelized, for those the event-driven path
+	 *	(a Scheduler over update()) is used as a fallback.
+	 *
+	 *	The levelized pass applies the combine_policy of Component,
+	 *	re-implemented evaluate() methods are only honoured by the fallback.
+	 *	Changing the topology of the graph requires another compile().
+	 *
+	 *	evaluate(ThreadPool&) evaluates the Components of a level in parallel, with a barrier between levels.
+	 *
+	 *	\param	Component
+	 *		The SynchrotronComponent type of the graph.
+	 */
+	template <class Component>
+	class CompiledNetlist {
+		public:
+			typedef typename std::decay<decltype(std::declval<const Component&>().getState())>::type state_type;
+			typedef typename Component::combine_policy combine_policy;
+
+		private:
+			/**	\brief
+			 *	Every Component in the graph, in level order.
+			 */
+			std::vector<Component*> components;
+
+			/**	\brief
+			 *	The state of every Component, same order as components.
+			 */
+			std::vector<state_type> states;
+
+			/**	\brief
+			 *	The inputs of components[i] are in inputIndices[inputOffsets[i] .. inputOffsets[i+1]].
+			 */
+			std::vector<size_t> inputOffsets;
+
+			/**	\brief
+			 *	Indices into states of every input, grouped per Component.
+			 */
+			std::vector<size_t> inputIndices;
+
+			/**	\brief
+			 *	Level l holds components[levelOffsets[l] .. levelOffsets[l+1]].
+			 */
+			std::vector<size_t> levelOffsets;
+
+			/**	\brief
+			 *	Whether the graph could be levelized.
+			 */
+			bool acyclic;
+
+		public:
+			/** \brief	Default constructor, compile() still has to be called.
+			 */
+			CompiledNetlist() : acyclic(true) {}
+
+			/** \brief	Compiles the graph connected to the Components in list.
+			 *
+			 *	\param	list
+			 *		Any of the Components in the graph(s) to compile.
+			 */
+			CompiledNetlist(std::initializer_list<Component*> list) : CompiledNetlist() {
+				this->compile(list.begin(), list.end());
+			}
+
+			/** \brief	Compiles the graph connected to the Components in [first, last).
+			 *
+			 *	\param	first, last
+			 *		A range of Component* from the graph(s) to compile.
+			 */
+			template <class InputIt>
+			CompiledNetlist(InputIt first, InputIt last) : CompiledNetlist() {
+				this->compile(first, last);
+			}
+
+			/**	\brief	(Re)builds the levelized arrays for the graph connected to [first, last).
+			 *
+			 *	\param	first, last
+			 *		A range of Component* from the graph(s) to compile.
+			 */
+			template <class InputIt>
+			void compile(InputIt first, InputIt last) {
+				const std::vector<Component*> nodes = collectComponents<Component>(first, last);
+				std::vector<std::vector<Component*>> levels;
+
+				this->acyclic = levelizeComponents(nodes, levels);
+				this->components.clear();
+				this->levelOffsets.assign(1, 0);
+
+				if (this->acyclic) {
+					for(auto& level : levels) {
+						this->components.insert(this->components.end(), level.begin(), level.end());
+						this->levelOffsets.push_back(this->components.size());
+					}
+				} else {
+					// No levels: the fallback only needs the Components
+					this->components = nodes;
+					this->levelOffsets.push_back(this->components.size());
+				}
+
+				const auto index = indexComponents(this->components);
+
+				this->inputOffsets.assign(1, 0);
+				this->inputIndices.clear();
+
+				for(auto& c : this->components) {
+					for(auto& sender : c->getInputs())
+						this->inputIndices.push_back(index.at(sender));
+
+					this->inputOffsets.push_back(this->inputIndices.size());
+				}
+
+				this->states.resize(this->components.size());
+				this->load();
+			}
+
+			/**	\brief	Whether the graph could be levelized, if not, the event-driven fallback is used.
+			 *
+			 *	\return	bool
+			 *		Returns false if the graph contains a cycle.
+			 */
+			bool isAcyclic() const {
+				return this->acyclic;
+			}
+
+			/**	\brief	Gets the amount of levels in the graph.
+			 *
+			 *	\return	size_t
+			 *		Returns the depth of the graph, or 1 for a cyclic graph.
+			 */
+			size_t getLevelCount() const {
+				return this->levelOffsets.size() - 1;
+			}
+
+			/**	\brief	Gets the Components in the graph, in level order.
+			 *
+			 *	\return	std::vector<Component*>&
+			 *		Returns a reference to every Component.
+			 */
+			const std::vector<Component*>& getComponents() const {
+				return this->components;
+			}
+
+			/**	\brief	Gets the contiguous array of states, in level order.
+			 *
+			 *	\return	std::vector<state_type>&
+			 *		Returns a reference to the state of every Component, same order as getComponents().
+			 */
+			const std::vector<state_type>& getStates() const {
+				return this->states;
+			}
+
+			/**	\brief	Copies the state of every Component into the contiguous array.
+			 */
+			void load() {
+				for(size_t i = 0; i < this->components.size(); i++)
+					this->states[i] = this->components[i]->getState();
+			}
+
+			/**	\brief	Copies the contiguous array back into the state of every Component.
+			 */
+			void store() {
+				for(size_t i = 0; i < this->components.size(); i++)
+					this->components[i]->setState(this->states[i]);
+			}
+
+			/**	\brief	Evaluates the contiguous array once, level by level.
+			 *
+			 *	For a cyclic graph, every Component is scheduled and updated through
+			 *	the event-driven Scheduler instead, which works on the Components directly.
+			 */
+			void evaluate() {
+				if (!this->acyclic) {
+					Scheduler<Component> scheduler;
+
+					this->store();
+
+					for(auto& c : this->components)
+						scheduler.schedule(*c);
+
+					scheduler.run();
+					this->load();
+					return;
+				}
+
+				if (this->getLevelCount() < 2)
+					return;
+
+				// Level 0 has no inputs, so it can be skipped
+				const size_t* indices = this->inputIndices.data();
+				auto get = [this](size_t j) -> const state_type& { return this->states[j]; };
+
+				for(size_t i = this->levelOffsets[1]; i < this->components.size(); i++) {
+					// Same logic as SynchrotronComponent::evaluate()
+					this->states[i] = combine_policy::reduce(this->states[i],
+															 indices + this->inputOffsets[i],
+															 indices + this->inputOffsets[i + 1], get);
+				}
+			}
+
+			/**	\brief	Evaluates the contiguous array once, the Components of each level in parallel.
+			 *
+			 *	Every level is a parallelFor() over the pool, which returns once the level is done,
+			 *	so level l+1 only reads states written before the barrier.
+			 *	The chunks start on a cache line of states, so two threads never write to the same line.
+			 *
+			 *	A cyclic graph uses the event-driven fallback, on the calling thread.
+			 *
+			 *	\param	pool
+			 *		The threads to evaluate on.
+			 *	\param	lines_per_chunk
+			 *		The amount of cache lines of states per chunk, more means less scheduling overhead per chunk.
+			 */
+			void evaluate(ThreadPool& pool, size_t lines_per_chunk = 16) {
+				if (!this->acyclic || pool.size() == 1) {
+					this->evaluate();
+					return;
+				}
+
+				const size_t* indices = this->inputIndices.data();
+				auto get = [this](size_t j) -> const state_type& { return this->states[j]; };
+
+				for(size_t l = 1; l < this->getLevelCount(); l++) {
+					pool.parallelForLines(this->states.data(), this->levelOffsets[l], this->levelOffsets[l + 1], lines_per_chunk,
+										  [&](size_t first, size_t last) {
+						for(size_t i = first; i < last; i++) {
+							this->states[i] = combine_policy::reduce(this->states[i],
+																	 indices + this->inputOffsets[i],
+																	 indices + this->inputOffsets[i + 1], get);
+						}
+					});
+				}
+			}
+
+			/**	\brief	Runs one full cycle: load(), evaluate() and store().
+			 */
+			void cycle() {
+				this->load();
+				this->evaluate();
+				this->store();
+			}
+
+			/**	\brief	Runs one full cycle, evaluating on pool: load(), evaluate(pool) and store().
+			 */
+			void cycle(ThreadPool& pool) {
+				this->load();
+				this->evaluate(pool);
+				this->store();
+			}
+	};
+}
+
+#endif // SYNCHROTRONCOMPILED_HPP
@@ -7,51 +7,35 @@
 
 #include <iostream> // For testing for now
 
+#include "SynchrotronCombine.hpp"
+#include "SynchrotronLock.hpp"
+#include "SynchrotronMemory.hpp"
+#include "SynchrotronStateArray.hpp"
+#include "SynchrotronStats.hpp"
+#include "SynchrotronTrace.hpp"
+#include <algorithm>
 #include <bitset>
+#include <memory>
 #include <set>
 #include <initializer_list>
 #include <mutex>
+#include <type_traits>
+#include <vector>
 
 namespace Synchrotron {
 
-    /** \brief Mutex class to lock the current working thread.
+    /** \brief Mutex class to lock the current working thread, using a std::mutex.
 	 *
-	 *	Includes a `static size_t` with an increment when a new instance is created.
-	 *	This is used in a custom compare method  `Mutex::compare`.
+	 *	Gets its unique id from MutexId, which is used in a custom compare method `Mutex::compare`.
+	 *	Components select their lock with a LockPolicy instead (see SynchrotronLock.hpp).
      */
-	class Mutex {
-		protected:
-			static size_t mutex_id;
-		private:
-			const size_t idx;
-			std::mutex m_mutex;
-		public:
-			Mutex() : idx(mutex_id++)		{}
-			Mutex(const Mutex&) : Mutex()	{}
-			virtual ~Mutex()				{}
-			virtual void lock()				{ m_mutex.lock();	}
-			virtual void unlock()			{ m_mutex.unlock();	}
-
-			struct compare {
-				inline bool operator() (const Mutex* lhs, const Mutex* rhs) const {
-					return lhs->idx < rhs->idx;
-				}
-			};
-	};
-
-	size_t Mutex::mutex_id = 0;
+	typedef BasicMutex<StdMutexLock> Mutex;
 
 	/**	\brief
 	 *	Creating a new LockBlock(this) locks the current thread,
 	 *	while leaving the scope conveniently unlocks the thread.
 	 */
-	class LockBlock {
-		public:
-			Mutex *m_mutex;
-			LockBlock(Mutex *mtx)
-				: m_mutex(mtx)		{ m_mutex->lock();		}
-			~LockBlock()			{ m_mutex->unlock();	}
-	};
+	typedef BasicLockBlock<Mutex> LockBlock;
 
 	/** \brief
 	 *	SynchrotronComponent is the base for all components,
@@ -59,14 +43,26 @@ namespace Synchrotron {
 	 *
 	 *	\param	bit_width
 	 *		This template argument specifies the width of the internal bitset state.
+	 *	\param	CombinePolicy
+	 *		This template argument specifies the logic applied on the input states (see SynchrotronCombine.hpp).
+	 *	\param	LockPolicy
+	 *		This template argument specifies the lock: NoLock, SpinLock or StdMutexLock (see SynchrotronLock.hpp).
+	 *	\param	Allocator
+	 *		This template argument specifies the allocator of the connections, e.g. an ArenaAllocator (see SynchrotronArena.hpp).
+	 *	\param	StatePolicy
+	 *		This template argument specifies where the state is kept: InlineState, or ExternalState for the StateArray of a Netlist (see SynchrotronStateArray.hpp).
      */
-	template <size_t bit_width>
-	class SynchrotronComponent : public Mutex {
-		protected:
-			/**	\brief
-			 *	The current internal state of bits in this component (default output).
-			 */
-			std::bitset<bit_width> state;
+	template <size_t bit_width, class CombinePolicy = OrPolicy, class LockPolicy = StdMutexLock, class Allocator = std::allocator<void*>, class StatePolicy = InlineState>
+	class SynchrotronComponent : public BasicMutex<LockPolicy>, public StatePolicy::template storage<std::bitset<bit_width>> {
+		private:
+			typedef BasicLockBlock<BasicMutex<LockPolicy>> LockBlock;
+			typedef BasicDualLockBlock<BasicMutex<LockPolicy>> DualLockBlock;
+			typedef BasicMultiLockBlock<BasicMutex<LockPolicy>> MultiLockBlock;
+			typedef typename std::allocator_traits<Allocator>::template rebind_alloc<SynchrotronComponent*> connection_allocator;
+
+		public:
+			typedef Allocator allocator_type;
+			typedef std::set<SynchrotronComponent*, std::less<SynchrotronComponent*>, connection_allocator> connection_container;
 
 		private:
 			/**	\brief
@@ -74,14 +70,14 @@ namespace Synchrotron {
 			 *
 			 *		Emit this.signal to subscribers in slotOutput.
 			 */
-			std::set<SynchrotronComponent*> slotOutput;
+			connection_container slotOutput;
 
 			/**	\brief
 			 *	**Signals == inputs**
 			 *
 			 *		Receive tick()s from these subscriptions in signalInput.
 			 */
-			std::set<SynchrotronComponent*> signalInput;
+			connection_container signalInput;
 
             /**	\brief	Connect a new slot s:
              *		* Add s to this SynchrotronComponent's outputs.
@@ -112,14 +108,34 @@ namespace Synchrotron {
 			}
 
 		public:
+			typedef CombinePolicy combine_policy;
+
             /** \brief	Default constructor
              *
              *	\param	initial_value
 			 *		The initial state of the internal bitset.
+			 *	\param	alloc
+			 *		The allocator for the connections.
 			 *	\param	bit_width
 			 *		The size of the internal width of the bitset.
              */
-			SynchrotronComponent(size_t initial_value = 0) : state(initial_value) {}
+			SynchrotronComponent(size_t initial_value = 0, const Allocator& alloc = Allocator())
+				: StatePolicy::template storage<std::bitset<bit_width>>(initial_value), slotOutput(connection_allocator(alloc)), signalInput(connection_allocator(alloc)) {}
+
+			/** \brief	State storage constructor, keeps the state in storage instead of in this SynchrotronComponent.
+			 *
+			 *		Only if StatePolicy is ExternalState.
+			 *
+			 *	\param	storage
+			 *		Where to keep the state, must outlive this SynchrotronComponent (e.g. a slot of a StateArray).
+			 *	\param	initial_value
+			 *		The initial state of the internal bitset.
+			 *	\param	alloc
+			 *		The allocator for the connections.
+			 */
+			template <class S = StatePolicy, class = typename std::enable_if<S::external>::type>
+			SynchrotronComponent(std::bitset<bit_width>& storage, size_t initial_value = 0, const Allocator& alloc = Allocator())
+				: StatePolicy::template storage<std::bitset<bit_width>>(storage, initial_value), slotOutput(connection_allocator(alloc)), signalInput(connection_allocator(alloc)) {}
 
 			/**	\brief **[Thread safe]**
 			 *	Copy constructor
@@ -131,7 +147,7 @@ namespace Synchrotron {
 			 *	\param	duplicateAll_IO
 			 *		Specifies whether to only copy inputs (false) or outputs as well (true).
 			 */
-			SynchrotronComponent(const SynchrotronComponent& sc, bool duplicateAll_IO = false) : SynchrotronComponent() {
+			SynchrotronComponent(const SynchrotronComponent& sc, bool duplicateAll_IO = false) : SynchrotronComponent(0, sc.get_allocator()) {
 				//LockBlock lock(this);
 
 				// Copy subscriptions
@@ -169,21 +185,60 @@ namespace Synchrotron {
 			 *		When called, will disconnect all in and output connections to this SynchrotronComponent.
              */
 			~SynchrotronComponent() {
-				LockBlock lock(this);
+				this->disconnectAll([](const SynchrotronComponent*) { return false; });
+			}
 
-				// Disconnect all Slots
-				for(auto& connection : this->slotOutput) {
-					connection->signalInput.erase(this);
-					//delete connection; //?
-				}
+			/**	\brief	**[Thread safe]** Disconnects all in and outputs, as part of tearing down a whole netlist.
+			 *
+			 *		Only removes this from the connections for which dying(connection) is false.
+			 *		The connections that are destroyed together with this keep their (dangling) pointer to this,
+			 *		which saves erasing every edge from both ends (see Netlist::clear()).
+			 *		Locks this together with every connection that is left, like removeOutput() locks both ends.
+			 *
+			 *	\param	dying
+			 *		Predicate returning whether a connected SynchrotronComponent is destroyed together with this one.
+			 */
+			template <class Predicate>
+			void disconnectAll(Predicate dying) {
+				std::vector<SynchrotronComponent*> neighbours, current;
 
-				// Disconnect all Signals
-				for(auto &sender: this->signalInput) {
-					sender->slotOutput.erase(this);
+				auto snapshot = [&](std::vector<SynchrotronComponent*>& into) {
+					into.clear();
+
+					for(auto& connection : this->slotOutput)
+						if (!dying(connection)) into.push_back(connection);
+
+					for(auto& sender : this->signalInput)
+						if (!dying(sender)) into.push_back(sender);
+				};
+
+				{
+					LockBlock lock(this);
+					snapshot(neighbours);
 				}
 
-				this->slotOutput.clear();
-				this->signalInput.clear();
+				// Lock the neighbours as well, and start over if a connection changed before they were all locked
+				for(;; neighbours.swap(current)) {
+					MultiLockBlock lock(this, neighbours.begin(), neighbours.end());
+					snapshot(current);
+
+					if (current != neighbours)
+						continue;
+
+					for(auto& connection : this->slotOutput) {
+						if (!dying(connection))
+							connection->signalInput.erase(this);
+					}
+
+					for(auto& sender : this->signalInput) {
+						if (!dying(sender))
+							sender->slotOutput.erase(this);
+					}
+
+					this->slotOutput.clear();
+					this->signalInput.clear();
+					return;
+				}
 			}
 
             /**	\brief	Gets this SynchrotronComponent's bit width.
@@ -218,24 +273,64 @@ namespace Synchrotron {
 				return this->state;
 			}
 
+			/**	\brief	Gets this SynchrotronComponent's state by reference, without copying it.
+			 *
+			 *	\return	const std::bitset<bit_width>&
+			 *		Returns the internal bitset, valid as long as this SynchrotronComponent.
+			 */
+			inline const std::bitset<bit_width>& getStateRef() const {
+				return this->state;
+			}
+
+			/**	\brief	Sets this SynchrotronComponent's state, without emitting.
+			 *
+			 *	\param	newState
+			 *		The new internal bitset.
+			 */
+			inline void setState(const std::bitset<bit_width>& newState) {
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), this->state, newState);
+				this->state = newState;
+			}
+
 			/**	\brief	Gets the SynchrotronComponent's input connections.
              *
-             *	\return	std::set<SynchrotronComponent*>&
+             *	\return	const connection_container&
              *      Returns a reference set to this SynchrotronComponent's inputs.
              */
-			const std::set<SynchrotronComponent*>& getInputs() const {
+			const connection_container& getInputs() const {
 				return this->signalInput;
 			}
 
 			/**	\brief	Gets the SynchrotronComponent's output connections.
              *
-             *	\return	std::set<SynchrotronComponent*>&
+             *	\return	const connection_container&
              *      Returns a reference set to this SynchrotronComponent's outputs.
              */
-			const std::set<SynchrotronComponent*>& getOutputs() const {
+			const connection_container& getOutputs() const {
 				return this->slotOutput;
 			}
 
+			/**	\brief	Gets the allocator of the connections.
+			 *
+			 *	\return	Allocator
+			 *		Returns a copy of the allocator this SynchrotronComponent was constructed with.
+			 */
+			allocator_type get_allocator() const {
+				return allocator_type(this->slotOutput.get_allocator());
+			}
+
+			/**	\brief	Gets the memory used by this SynchrotronComponent: the object itself (with its lock),
+			 *		and the heap nodes and spare capacity of its connections (see SynchrotronMemory.hpp).
+			 *
+			 *		Not synchronized, like getOutputs().
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of bytes.
+			 */
+			size_t memoryUsage() const {
+				return sizeof(*this) + Memory::heapUsage(this->slotOutput) + Memory::heapUsage(this->signalInput);
+			}
+
             /**	\brief	**[Thread safe]** Adds/Connects a new input to this SynchrotronComponent.
              *
              *	**Ensures both way connection will be made:**
@@ -245,22 +340,43 @@ namespace Synchrotron {
              *		The SynchrotronComponent to connect as input.
              */
 			virtual void addInput(SynchrotronComponent& input) {
-				LockBlock lock(this);
+				DualLockBlock lock(this, &input);
 
 				// deprecated? //if (!this->hasSameWidth(input)) return false;
 				input.connectSlot(this);
 			}
 
+			/**	\brief	**[Thread safe]** Adds/Connects a range of new inputs to this SynchrotronComponent.
+			 *
+			 *	The range is sorted in the order of the connections and duplicates are dropped first,
+			 *	so they are appended instead of searched for one by one.
+			 *	This is locked once for every input after it in the lock order, and each input only while it is connected (see forEachLocked()).
+			 *
+			 *	\param	first, last
+			 *		The range of SynchrotronComponent* to connect as input.
+			 */
+			template <class InputIt>
+			void addInput(InputIt first, InputIt last) {
+				std::vector<SynchrotronComponent*> inputs(first, last);
+
+				std::sort(inputs.begin(), inputs.end(), std::less<SynchrotronComponent*>());
+				inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+
+				forEachLocked(this, inputs.begin(), inputs.end(), [this](SynchrotronComponent* input) {
+					input->slotOutput.insert(this);
+					this->signalInput.insert(this->signalInput.end(), input);
+				});
+			}
+
 			/**	\brief	Adds/Connects a list of new inputs to this SynchrotronComponent.
              *
-             *	Calls addInput() on each SynchrotronComponent* in inputList.
+             *	Same as addInput(first, last).
              *
              *	\param	inputList
              *		The list of SynchrotronComponents to connect as input.
              */
 			void addInput(std::initializer_list<SynchrotronComponent*> inputList) {
-				for(auto connection : inputList)
-					this->addInput(*connection);
+				this->addInput(inputList.begin(), inputList.end());
 			}
 
             /**	\brief	**[Thread safe]** Removes/Disconnects an input to this SynchrotronComponent.
@@ -272,7 +388,7 @@ namespace Synchrotron {
              *		The SynchrotronComponent to disconnect as input.
              */
 			void removeInput(SynchrotronComponent& input) {
-				LockBlock lock(this);
+				DualLockBlock lock(this, &input);
 
 				input.disconnectSlot(this);
 			}
@@ -286,22 +402,43 @@ namespace Synchrotron {
              *		The SynchrotronComponent to connect as output.
              */
 			void addOutput(SynchrotronComponent& output) {
-				LockBlock lock(this);
+				DualLockBlock lock(this, &output);
 
 				// deprecated? //if (!this->hasSameWidth(*output)) return false;
 				this->connectSlot(&output);
 			}
 
+			/**	\brief	**[Thread safe]** Adds/Connects a range of new outputs to this SynchrotronComponent.
+			 *
+			 *	The range is sorted in the order of the connections and duplicates are dropped first,
+			 *	so they are appended instead of searched for one by one.
+			 *	This is locked once for every output after it in the lock order, and each output only while it is connected (see forEachLocked()).
+			 *
+			 *	\param	first, last
+			 *		The range of SynchrotronComponent* to connect as output.
+			 */
+			template <class InputIt>
+			void addOutput(InputIt first, InputIt last) {
+				std::vector<SynchrotronComponent*> outputs(first, last);
+
+				std::sort(outputs.begin(), outputs.end(), std::less<SynchrotronComponent*>());
+				outputs.erase(std::unique(outputs.begin(), outputs.end()), outputs.end());
+
+				forEachLocked(this, outputs.begin(), outputs.end(), [this](SynchrotronComponent* output) {
+					this->slotOutput.insert(this->slotOutput.end(), output);
+					output->signalInput.insert(this);
+				});
+			}
+
 			/**	\brief	Adds/Connects a list of new outputs to this SynchrotronComponent.
              *
-             *	Calls addOutput() on each SynchrotronComponent* in outputList.
+             *	Same as addOutput(first, last).
              *
              *	\param	outputList
              *		The list of SynchrotronComponents to connect as output.
              */
 			void addOutput(std::initializer_list<SynchrotronComponent*> outputList) {
-				for(auto connection : outputList)
-					this->addOutput(*connection);
+				this->addOutput(outputList.begin(), outputList.end());
 			}
 
 			/**	\brief	**[Thread safe]** Removes/Disconnects an output to this SynchrotronComponent.
@@ -313,11 +450,42 @@ namespace Synchrotron {
              *		The SynchrotronComponent to disconnect as output.
              */
 			void removeOutput(SynchrotronComponent& output) {
-				LockBlock lock(this);
+				DualLockBlock lock(this, &output);
 
 				this->disconnectSlot(&output);
 			}
 
+			/**	\brief	Computes the state this SynchrotronComponent would get from its inputs, without applying it.
+			 *
+			 *	\return	virtual std::bitset<bit_width>
+			 *		Reduces the inputs with CombinePolicy, a derived class can re-implement this
+			 *		for logic that doesn't fit a policy.
+			 */
+			virtual std::bitset<bit_width> evaluate() const {
+				SYNCHROTRON_STATS_EVALUATE(this->signalInput.size());
+
+				return CombinePolicy::reduce(this->state, this->signalInput.begin(), this->signalInput.end(),
+											 [](const SynchrotronComponent* connection) -> const std::bitset<bit_width>& { return connection->getStateRef(); });
+			}
+
+			/**	\brief	Applies evaluate() to this SynchrotronComponent's state, without emitting.
+			 *
+			 *	Used by tick() and by the iterative Scheduler to propagate without recursion.
+			 *
+			 *	\return	bool
+			 *		Returns whether the state has changed.
+			 */
+			bool update() {
+				std::bitset<bit_width> prevState = this->state;
+
+				this->state = this->evaluate();
+
+				SYNCHROTRON_STATS_TICK(prevState != this->state);
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), prevState, this->state);
+
+				return prevState != this->state;
+			}
+
 			/**	\brief	The tick() method will be called when one of this SynchrotronComponent's inputs issues an emit().
 			 *
              *	\return	virtual void
@@ -325,31 +493,64 @@ namespace Synchrotron {
              */
 			virtual void tick() {
 				//LockBlock lock(this);
-				std::bitset<bit_width> prevState = this->state;
 
 				//std::cout << "Ticked\n";
-				for(auto& connection : this->signalInput) {
-					// Change this line to change the logic applied on the states:
-					this->state |= ((SynchrotronComponent*) connection)->getState();
-				}
+				// Directly emit changes to subscribers on change
+				if (this->update())
+					this->emit();
+			}
+
+			/**	\brief	The tick(source) method will be called when source, one of this SynchrotronComponent's inputs, issues an emit().
+			 *
+			 *	\param	source
+			 *		The input that emitted.
+			 *
+			 *	\return	virtual void
+			 *		Calls tick(), so a derived class re-implementing tick() or evaluate() keeps working.
+			 *		Incremental<SynchrotronComponent> re-implements it to merge only source (see SynchrotronCombine.hpp).
+			 */
+			virtual void tick(SynchrotronComponent& source) {
+				(void) source;
+				this->tick();
+			}
+
+		protected:
+			/**	\brief	Merges only the state of source and emits on change, at O(1) instead of O(fan-in) per input event.
+			 *
+			 *	Only gives the same state as tick() if CombinePolicy is incremental (e.g. OR, which is monotone)
+			 *	and the state already holds every other input, i.e. it was tick()ed since they were connected.
+			 *
+			 *	\param	source
+			 *		The input that emitted.
+			 */
+			void tickMerge(const SynchrotronComponent& source) {
+				//LockBlock lock(this);
+				std::bitset<bit_width> prevState = this->state;
+
+				CombinePolicy::merge(this->state, source.getStateRef());
+				SYNCHROTRON_STATS_TICK(prevState != this->state);
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), prevState, this->state);
 
 				// Directly emit changes to subscribers on change
 				if (prevState != this->state)
 					this->emit();
 			}
 
+		public:
+
 			/**	\brief	The emit() method will be called after a tick() completes to ensure the flow of new data.
 			 *
-			 *	Loops over all outputs and calls tick().
+			 *	Loops over all outputs and calls tick(*this).
 			 *
              *	\return	virtual void
              *		This method can be re-implemented by a derived class.
              */
 			virtual inline void emit() {
 				//LockBlock lock(this);
+				SYNCHROTRON_STATS_EMIT(this->slotOutput.size());
 
 				for(auto& connection : this->slotOutput) {
-					connection->tick();
+					connection->tick(*this);
 				}
 				//std::cout << "Emitted\n";
 			}
@@ -0,0 +1,557 @@
+#ifndef SYNCHROTRONCOMPONENTRCU_HPP
+#define SYNCHROTRONCOMPONENTRCU_HPP
+
+#include <iostream> // For testing for now
+
+#include "SynchrotronComponent.hpp"
+#include "SynchrotronEpoch.hpp"
+#include "SynchrotronRcuSet.hpp"
+#include <algorithm>
+#include <bitset>
+#include <memory>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	SynchrotronComponent is the base for all components,
+	 *	offering in and output connections to other SynchrotronComponent.
+	 *
+	 *	Keeps its connections in an RcuSet (sorted by `Mutex::compare` like SynchrotronComponentSetSort),
+	 *	so emit() and evaluate() traverse them without a lock while other threads add and remove connections.
+	 *	Those only lock the Components they change (see SynchrotronLock.hpp), and publish a new version of
+	 *	the connections. The previous version is freed after the grace period (see SynchrotronEpoch.hpp).
+	 *	A destroyed SynchrotronComponentRcu waits for that grace period as well, since an old version of
+	 *	a neighbour's connections may still point to it. Only the connections are protected this way, the states are not.
+	 *
+	 *	\param	bit_width
+	 *		This template argument specifies the width of the internal bitset state.
+	 *	\param	CombinePolicy
+	 *		This template argument specifies the logic applied on the input states (see SynchrotronCombine.hpp).
+	 *	\param	LockPolicy
+	 *		This template argument specifies the lock: NoLock, SpinLock or StdMutexLock (see SynchrotronLock.hpp).
+	 *	\param	StatePolicy
+	 *		This template argument specifies where the state is kept: InlineState, or ExternalState for the StateArray of a Netlist (see SynchrotronStateArray.hpp).
+	 */
+	template <size_t bit_width, class CombinePolicy = OrPolicy, class LockPolicy = StdMutexLock, class StatePolicy = InlineState>
+	class SynchrotronComponentRcu : public BasicMutex<LockPolicy>, public StatePolicy::template storage<std::bitset<bit_width>> {
+		private:
+			typedef BasicLockBlock<BasicMutex<LockPolicy>> LockBlock;
+			typedef BasicDualLockBlock<BasicMutex<LockPolicy>> DualLockBlock;
+			typedef BasicMultiLockBlock<BasicMutex<LockPolicy>> MultiLockBlock;
+
+		public:
+			// Retired versions can outlive an Arena, so the connections always come from the heap
+			typedef std::allocator<void*> allocator_type;
+			typedef RcuSet<SynchrotronComponentRcu*, Mutex::compare> connection_container;
+			typedef typename connection_container::view connection_view;
+
+		private:
+			/**	\brief
+			 *	**Slots == outputs**
+			 *
+			 *		Emit this.signal to subscribers in slotOutput.
+			 */
+			connection_container slotOutput;
+
+			/**	\brief
+			 *	**Signals == inputs**
+			 *
+			 *		Receive tick()s from these subscriptions in signalInput.
+			 */
+			connection_container signalInput;
+
+			/**	\brief	Connect a new slot s:
+			 *		* Add s to this SynchrotronComponentRcu's outputs.
+			 *		* Add this to s's inputs.
+			 *
+			 *	\param	s
+			 *		The SynchrotronComponentRcu to connect.
+			 */
+			inline void connectSlot(SynchrotronComponentRcu* s) {
+				//LockBlock lock(this);
+
+				this->slotOutput.insert(s);
+				s->signalInput.insert(this);
+			}
+
+			/**	\brief	Disconnect a slot s:
+			 *		* Remove s from this SynchrotronComponentRcu's outputs.
+			 *		* Remove this from s's inputs.
+			 *
+			 *	\param	s
+			 *		The SynchrotronComponentRcu to disconnect.
+			 */
+			inline void disconnectSlot(SynchrotronComponentRcu* s) {
+				//LockBlock lock(this);
+
+				this->slotOutput.erase(s);
+				s->signalInput.erase(this);
+			}
+
+		public:
+			typedef CombinePolicy combine_policy;
+
+			/** \brief	Default constructor
+			 *
+			 *	\param	initial_value
+			 *		The initial state of the internal bitset.
+			 *	\param	alloc
+			 *		Unused, for compatibility with Netlist.
+			 *	\param	bit_width
+			 *		The size of the internal width of the bitset.
+			 */
+			SynchrotronComponentRcu(size_t initial_value = 0, const allocator_type& = allocator_type())
+				: StatePolicy::template storage<std::bitset<bit_width>>(initial_value) {}
+
+			/** \brief	State storage constructor, keeps the state in storage instead of in this SynchrotronComponentRcu.
+			 *
+			 *		Only if StatePolicy is ExternalState.
+			 *
+			 *	\param	storage
+			 *		Where to keep the state, must outlive this SynchrotronComponentRcu (e.g. a slot of a StateArray).
+			 *	\param	initial_value
+			 *		The initial state of the internal bitset.
+			 */
+			template <class S = StatePolicy, class = typename std::enable_if<S::external>::type>
+			SynchrotronComponentRcu(std::bitset<bit_width>& storage, size_t initial_value = 0, const allocator_type& = allocator_type())
+				: StatePolicy::template storage<std::bitset<bit_width>>(storage, initial_value) {}
+
+			/**	\brief
+			 *	Copy constructor
+			 *	*	Duplicates signal subscriptions (inputs)
+			 *	*	Optionally also duplicates slot connections (outputs)
+			 *
+			 *	\param	sc const
+			 *		The other SynchrotronComponentRcu to duplicate the connections from.
+			 *	\param	duplicateAll_IO
+			 *		Specifies whether to only copy inputs (false) or outputs as well (true).
+			 */
+			SynchrotronComponentRcu(const SynchrotronComponentRcu& sc, bool duplicateAll_IO = false) : SynchrotronComponentRcu() {
+				//LockBlock lock(this);
+				EpochGuard guard;
+
+				// Copy subscriptions
+				for(auto& sender : sc.signalInput.read()) {
+					this->addInput(*sender);
+				}
+
+				if (duplicateAll_IO) {
+					// Copy subscribers
+					for(auto& connection : sc.slotOutput.read()) {
+						this->addOutput(*connection);
+					}
+				}
+			}
+
+			/**	\brief
+			 *	Connection constructor
+			 *	*	Adds signal subscriptions from inputList
+			 *	*	Optionally adds slot subscribers from outputList
+			 *
+			 *	\param	inputList
+			 *		The list of SynchrotronComponents to connect as input.
+			 *	\param	outputList
+			 *		The list of SynchrotronComponents to connect as output..
+			 */
+			SynchrotronComponentRcu(std::initializer_list<SynchrotronComponentRcu*> inputList,
+								 std::initializer_list<SynchrotronComponentRcu*> outputList = {})
+									: SynchrotronComponentRcu() {
+				this->addInput(inputList);
+				this->addOutput(outputList);
+			}
+
+			/** \brief	**[Thread safe]** Default destructor
+			 *
+			 *		When called, will disconnect all in and output connections to this SynchrotronComponentRcu,
+			 *		and wait for the grace period so no reader can still reach this once it is freed (see disconnectAll()).
+			 *		Must not be destroyed from inside an EpochGuard (e.g. in a tick()), it would wait for itself.
+			 */
+			~SynchrotronComponentRcu() {
+				this->disconnectAll([](const SynchrotronComponentRcu*) { return false; });
+			}
+
+			/**	\brief	**[Thread safe]** Disconnects all in and outputs, as part of tearing down a whole netlist.
+			 *
+			 *		Only removes this from the connections for which dying(connection) is false.
+			 *		The connections that are destroyed together with this keep their (dangling) pointer to this,
+			 *		which saves erasing every edge from both ends (see Netlist::clear()).
+			 *		Locks this together with every connection that is left, like removeOutput() locks both ends.
+			 *		If any was left, waits for the grace period (see EpochManager::synchronize()) before returning,
+			 *		so it must not be called from inside an EpochGuard.
+			 *
+			 *	\param	dying
+			 *		Predicate returning whether a connected SynchrotronComponentRcu is destroyed together with this one.
+			 */
+			template <class Predicate>
+			void disconnectAll(Predicate dying) {
+				std::vector<SynchrotronComponentRcu*> neighbours, current;
+
+				auto snapshot = [&](std::vector<SynchrotronComponentRcu*>& into) {
+					into.clear();
+
+					for(auto& connection : this->slotOutput.read())
+						if (!dying(connection)) into.push_back(connection);
+
+					for(auto& sender : this->signalInput.read())
+						if (!dying(sender)) into.push_back(sender);
+				};
+
+				{
+					LockBlock lock(this);
+					snapshot(neighbours);
+				}
+
+				// Lock the neighbours as well, and start over if a connection changed before they were all locked
+				for(;; neighbours.swap(current)) {
+					MultiLockBlock lock(this, neighbours.begin(), neighbours.end());
+					snapshot(current);
+
+					if (current != neighbours)
+						continue;
+
+					for(auto& connection : this->slotOutput.read()) {
+						if (!dying(connection))
+							connection->signalInput.erase(this);
+					}
+
+					for(auto& sender : this->signalInput.read()) {
+						if (!dying(sender))
+							sender->slotOutput.erase(this);
+					}
+
+					this->slotOutput.clear();
+					this->signalInput.clear();
+					break;
+				}
+
+				// A reader may still be in emit() or evaluate() on a version of a neighbour's connections that holds this
+				if (!neighbours.empty())
+					EpochManager::instance().synchronize();
+			}
+
+			/**	\brief	Gets this SynchrotronComponentRcu's bit width.
+			 *
+			 *	\return	size_t
+			 *      Returns the bit width of the internal bitset.
+			 */
+			size_t getBitWidth() const {
+				return bit_width;
+			}
+
+//			/* No real use since function cannot be called with different size SynchrotronComponentRcus */
+//			/* Maybe viable when SynchrotronComponentRcu has different in and output sizes */
+//			/*	\brief	Compare this bit width to that of other.
+//             *
+//             *	\param	other
+//			 *		The other SynchrotronComponentRcu to check.
+//			 *
+//             *	\return	bool
+//             *      Returns whether the widths match.
+//             */
+//			inline bool hasSameWidth(SynchrotronComponentRcu& other) {
+//				return this->getBitWidth() == other.getBitWidth();
+//			}
+
+			/**	\brief	Gets this SynchrotronComponentRcu's state.
+			 *
+			 *	\return	std::bitset<bit_width>
+			 *      Returns the internal bitset.
+			 */
+			inline std::bitset<bit_width> getState() const {
+				return this->state;
+			}
+
+			/**	\brief	Gets this SynchrotronComponentRcu's state by reference, without copying it.
+			 *
+			 *	\return	const std::bitset<bit_width>&
+			 *		Returns the internal bitset, valid as long as this SynchrotronComponentRcu.
+			 */
+			inline const std::bitset<bit_width>& getStateRef() const {
+				return this->state;
+			}
+
+			/**	\brief	Sets this SynchrotronComponentRcu's state, without emitting.
+			 *
+			 *	\param	newState
+			 *		The new internal bitset.
+			 */
+			inline void setState(const std::bitset<bit_width>& newState) {
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), this->state, newState);
+				this->state = newState;
+			}
+
+			/**	\brief	Gets the SynchrotronComponentRcu's input connections.
+			 *
+			 *	\return	connection_view
+			 *      Returns the current version of this SynchrotronComponentRcu's inputs,
+			 *		hold an EpochGuard while using it if other threads can change the connections.
+			 */
+			connection_view getInputs() const {
+				return this->signalInput.read();
+			}
+
+			/**	\brief	Gets the SynchrotronComponentRcu's output connections.
+			 *
+			 *	\return	connection_view
+			 *      Returns the current version of this SynchrotronComponentRcu's outputs,
+			 *		hold an EpochGuard while using it if other threads can change the connections.
+			 */
+			connection_view getOutputs() const {
+				return this->slotOutput.read();
+			}
+
+			/**	\brief	Gets the allocator of the connections.
+			 *
+			 *	\return	allocator_type
+			 *		Returns a std::allocator, the connections always come from the heap.
+			 */
+			allocator_type get_allocator() const {
+				return allocator_type();
+			}
+
+			/**	\brief	Gets the memory used by this SynchrotronComponentRcu: the object itself (with its lock),
+			 *		and the heap nodes and spare capacity of its connections (see SynchrotronMemory.hpp).
+			 *
+			 *		Not synchronized, like getOutputs().
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of bytes.
+			 */
+			size_t memoryUsage() const {
+				return sizeof(*this) + Memory::heapUsage(this->slotOutput) + Memory::heapUsage(this->signalInput);
+			}
+
+			/**	\brief	Adds/Connects a new input to this SynchrotronComponentRcu.
+			 *
+			 *	**Ensures both way connection will be made:**
+			 *	This will have input added to its inputs and input will have this added to its outputs.
+			 *
+			 *	\param	input
+			 *		The SynchrotronComponentRcu to connect as input.
+			 */
+			void addInput(SynchrotronComponentRcu& input) {
+				DualLockBlock lock(this, &input);
+
+				// deprecated? //if (!this->hasSameWidth(input)) return false;
+				input.connectSlot(this);
+			}
+
+			/**	\brief	**[Thread safe]** Adds/Connects a range of new inputs to this SynchrotronComponentRcu, taking the locks only once.
+			 *
+			 *	The range is sorted in the order of the connections (on ids read once) and duplicates are dropped first,
+			 *	so this publishes a single new version of its own connections, with every input locked at once.
+			 *
+			 *	\param	first, last
+			 *		The range of SynchrotronComponentRcu* to connect as input.
+			 */
+			template <class InputIt>
+			void addInput(InputIt first, InputIt last) {
+				std::vector<SynchrotronComponentRcu*> inputs(first, last);
+
+				sortByLockOrder(inputs);
+
+				MultiLockBlock lock(this, inputs.begin(), inputs.end());
+
+				for(auto input : inputs)
+					input->slotOutput.insert(this);
+
+				this->signalInput.insertSorted(inputs.begin(), inputs.end());
+			}
+
+			/**	\brief	Adds/Connects a list of new inputs to this SynchrotronComponent.
+			 *
+			 *	Same as addInput(first, last).
+			 *
+			 *	\param	inputList
+			 *		The list of SynchrotronComponents to connect as input.
+			 */
+			void addInput(std::initializer_list<SynchrotronComponentRcu*> inputList) {
+				this->addInput(inputList.begin(), inputList.end());
+			}
+
+			/**	\brief	Removes/Disconnects an input to this SynchrotronComponentRcu.
+			 *
+			 *	**Ensures both way connection will be removed:**
+			 *	This will have input removed from its inputs and input will have this removed from its outputs.
+			 *
+			 *	\param	input
+			 *		The SynchrotronComponentRcu to disconnect as input.
+			 */
+			void removeInput(SynchrotronComponentRcu& input) {
+				DualLockBlock lock(this, &input);
+
+				input.disconnectSlot(this);
+			}
+
+			/**	\brief	Adds/Connects a new output to this SynchrotronComponentRcu.
+			 *
+			 *	**Ensures both way connection will be made:**
+			 *	This will have output added to its outputs and output will have this added to its inputs.
+			 *
+			 *	\param	output
+			 *		The SynchrotronComponentRcu to connect as output.
+			 */
+			void addOutput(SynchrotronComponentRcu& output) {
+				DualLockBlock lock(this, &output);
+
+				// deprecated? //if (!this->hasSameWidth(*output)) return false;
+				this->connectSlot(&output);
+			}
+
+			/**	\brief	**[Thread safe]** Adds/Connects a range of new outputs to this SynchrotronComponentRcu, taking the locks only once.
+			 *
+			 *	The range is sorted in the order of the connections (on ids read once) and duplicates are dropped first,
+			 *	so this publishes a single new version of its own connections, with every output locked at once.
+			 *
+			 *	\param	first, last
+			 *		The range of SynchrotronComponentRcu* to connect as output.
+			 */
+			template <class InputIt>
+			void addOutput(InputIt first, InputIt last) {
+				std::vector<SynchrotronComponentRcu*> outputs(first, last);
+
+				sortByLockOrder(outputs);
+
+				MultiLockBlock lock(this, outputs.begin(), outputs.end());
+
+				for(auto output : outputs)
+					output->signalInput.insert(this);
+
+				this->slotOutput.insertSorted(outputs.begin(), outputs.end());
+			}
+
+			/**	\brief	Adds/Connects a list of new outputs to this SynchrotronComponent.
+			 *
+			 *	Same as addOutput(first, last).
+			 *
+			 *	\param	outputList
+			 *		The list of SynchrotronComponents to connect as output.
+			 */
+			void addOutput(std::initializer_list<SynchrotronComponentRcu*> outputList) {
+				this->addOutput(outputList.begin(), outputList.end());
+			}
+
+			/**	\brief	Removes/Disconnects an output to this SynchrotronComponentRcu.
+			 *
+			 *	**Ensures both way connection will be removed:**
+			 *	This will have output removed from its output and output will have this removed from its inputs.
+			 *
+			 *	\param	output
+			 *		The SynchrotronComponentRcu to disconnect as output.
+			 */
+			void removeOutput(SynchrotronComponentRcu& output) {
+				DualLockBlock lock(this, &output);
+
+				this->disconnectSlot(&output);
+			}
+
+			/**	\brief	Computes the state this SynchrotronComponentRcu would get from its inputs, without applying it.
+			 *
+			 *	\return	virtual std::bitset<bit_width>
+			 *		Reduces the inputs with CombinePolicy, a derived class can re-implement this
+			 *		for logic that doesn't fit a policy.
+			 */
+			virtual std::bitset<bit_width> evaluate() const {
+				EpochGuard guard;
+				const connection_view inputs = this->signalInput.read();
+				SYNCHROTRON_STATS_EVALUATE(inputs.size());
+
+				return CombinePolicy::reduce(this->state, inputs.begin(), inputs.end(),
+											 [](const SynchrotronComponentRcu* connection) -> const std::bitset<bit_width>& { return connection->getStateRef(); });
+			}
+
+			/**	\brief	Applies evaluate() to this SynchrotronComponentRcu's state, without emitting.
+			 *
+			 *	Used by tick() and by the iterative Scheduler to propagate without recursion.
+			 *
+			 *	\return	bool
+			 *		Returns whether the state has changed.
+			 */
+			bool update() {
+				std::bitset<bit_width> prevState = this->state;
+
+				this->state = this->evaluate();
+
+				SYNCHROTRON_STATS_TICK(prevState != this->state);
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), prevState, this->state);
+
+				return prevState != this->state;
+			}
+
+			/**	\brief	The tick() method will be called when one of this SynchrotronComponentRcu's inputs issues an emit().
+			 *
+			 *	\return	virtual void
+			 *		This method should be implemented by a derived class.
+			 */
+			virtual void tick() {
+				//LockBlock lock(this);
+
+				//std::cout << "Ticked\n";
+				// Directly emit changes to subscribers on change
+				if (this->update())
+					this->emit();
+			}
+
+			/**	\brief	The tick(source) method will be called when source, one of this SynchrotronComponentRcu's inputs, issues an emit().
+			 *
+			 *	\param	source
+			 *		The input that emitted.
+			 *
+			 *	\return	virtual void
+			 *		Calls tick(), so a derived class re-implementing tick() or evaluate() keeps working.
+			 *		Incremental<SynchrotronComponentRcu> re-implements it to merge only source (see SynchrotronCombine.hpp).
+			 */
+			virtual void tick(SynchrotronComponentRcu& source) {
+				(void) source;
+				this->tick();
+			}
+
+		protected:
+			/**	\brief	Merges only the state of source and emits on change, at O(1) instead of O(fan-in) per input event.
+			 *
+			 *	Only gives the same state as tick() if CombinePolicy is incremental (e.g. OR, which is monotone)
+			 *	and the state already holds every other input, i.e. it was tick()ed since they were connected.
+			 *
+			 *	\param	source
+			 *		The input that emitted.
+			 */
+			void tickMerge(const SynchrotronComponentRcu& source) {
+				//LockBlock lock(this);
+				std::bitset<bit_width> prevState = this->state;
+
+				CombinePolicy::merge(this->state, source.getStateRef());
+				SYNCHROTRON_STATS_TICK(prevState != this->state);
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), prevState, this->state);
+
+				// Directly emit changes to subscribers on change
+				if (prevState != this->state)
+					this->emit();
+			}
+
+		public:
+
+			/**	\brief	The emit() method will be called after a tick() completes to ensure the flow of new data.
+			 *
+			 *	Loops over all outputs and calls tick(*this), without a lock: inside an EpochGuard,
+			 *	the version of the outputs it loops over stays valid while other threads change them.
+			 *
+			 *	\return	virtual void
+			 *		This method can be re-implemented by a derived class.
+			 */
+			virtual inline void emit() {
+				//LockBlock lock(this);
+				EpochGuard guard;
+				const connection_view outputs = this->slotOutput.read();
+				SYNCHROTRON_STATS_EMIT(outputs.size());
+
+				for(auto& connection : outputs) {
+					connection->tick(*this);
+				}
+				//std::cout << "Emitted\n";
+			}
+	};
+}
+
+
+#endif // SYNCHROTRONCOMPONENTRCU_HPP
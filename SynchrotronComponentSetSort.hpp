@@ -4,8 +4,11 @@
 #include <iostream> // For testing for now
 
 #include "SynchrotronComponent.hpp"
+#include <algorithm>
 #include <bitset>
+#include <memory>
 #include <set>
+#include <vector>
 
 namespace Synchrotron {
 
@@ -15,28 +18,41 @@ namespace Synchrotron {
 	 *
 	 *	\param	bit_width
 	 *		This template argument specifies the width of the internal bitset state.
+	 *	\param	CombinePolicy
+	 *		This template argument specifies the logic applied on the input states (see SynchrotronCombine.hpp).
+	 *	\param	LockPolicy
+	 *		This template argument specifies the lock: NoLock, SpinLock or StdMutexLock (see SynchrotronLock.hpp).
+	 *	\param	Allocator
+	 *		This template argument specifies the allocator of the connections, e.g. an ArenaAllocator (see SynchrotronArena.hpp).
+	 *	\param	StatePolicy
+	 *		This template argument specifies where the state is kept: InlineState, or ExternalState for the StateArray of a Netlist (see SynchrotronStateArray.hpp).
 	 */
-	template <size_t bit_width>
-	class SynchrotronComponentSetSort : public Mutex {
+	template <size_t bit_width, class CombinePolicy = OrPolicy, class LockPolicy = StdMutexLock, class Allocator = std::allocator<void*>, class StatePolicy = InlineState>
+	class SynchrotronComponentSetSort : public BasicMutex<LockPolicy>, public StatePolicy::template storage<std::bitset<bit_width>> {
 		private:
-			/**	\brief
-			 *	The current internal state of bits in this component (default output).
-			 */
-			std::bitset<bit_width> state;
+			typedef BasicLockBlock<BasicMutex<LockPolicy>> LockBlock;
+			typedef BasicDualLockBlock<BasicMutex<LockPolicy>> DualLockBlock;
+			typedef BasicMultiLockBlock<BasicMutex<LockPolicy>> MultiLockBlock;
+			typedef typename std::allocator_traits<Allocator>::template rebind_alloc<SynchrotronComponentSetSort*> connection_allocator;
+
+		public:
+			typedef Allocator allocator_type;
+			typedef std::set<SynchrotronComponentSetSort*, Mutex::compare, connection_allocator> connection_container;
 
+		private:
 			/**	\brief
 			 *	**Slots == outputs**
 			 *
 			 *		Emit this.signal to subscribers in slotOutput.
 			 */
-			std::set<SynchrotronComponentSetSort*, Mutex::compare> slotOutput;
+			connection_container slotOutput;
 
 			/**	\brief
 			 *	**Signals == inputs**
 			 *
 			 *		Receive tick()s from these subscriptions in signalInput.
 			 */
-			std::set<SynchrotronComponentSetSort*, Mutex::compare> signalInput;
+			connection_container signalInput;
 
 			/**	\brief	Connect a new slot s:
 			 *		* Add s to this SynchrotronComponentSetSort's outputs.
@@ -67,14 +83,34 @@ namespace Synchrotron {
 			}
 
 		public:
+			typedef CombinePolicy combine_policy;
+
 			/** \brief	Default constructor
 			 *
 			 *	\param	initial_value
 			 *		The initial state of the internal bitset.
+			 *	\param	alloc
+			 *		The allocator for the connections.
 			 *	\param	bit_width
 			 *		The size of the internal width of the bitset.
 			 */
-			SynchrotronComponentSetSort(size_t initial_value = 0) : state(initial_value) {}
+			SynchrotronComponentSetSort(size_t initial_value = 0, const Allocator& alloc = Allocator())
+				: StatePolicy::template storage<std::bitset<bit_width>>(initial_value), slotOutput(connection_allocator(alloc)), signalInput(connection_allocator(alloc)) {}
+
+			/** \brief	State storage constructor, keeps the state in storage instead of in this SynchrotronComponentSetSort.
+			 *
+			 *		Only if StatePolicy is ExternalState.
+			 *
+			 *	\param	storage
+			 *		Where to keep the state, must outlive this SynchrotronComponentSetSort (e.g. a slot of a StateArray).
+			 *	\param	initial_value
+			 *		The initial state of the internal bitset.
+			 *	\param	alloc
+			 *		The allocator for the connections.
+			 */
+			template <class S = StatePolicy, class = typename std::enable_if<S::external>::type>
+			SynchrotronComponentSetSort(std::bitset<bit_width>& storage, size_t initial_value = 0, const Allocator& alloc = Allocator())
+				: StatePolicy::template storage<std::bitset<bit_width>>(storage, initial_value), slotOutput(connection_allocator(alloc)), signalInput(connection_allocator(alloc)) {}
 
 			/**	\brief
 			 *	Copy constructor
@@ -86,7 +122,7 @@ namespace Synchrotron {
 			 *	\param	duplicateAll_IO
 			 *		Specifies whether to only copy inputs (false) or outputs as well (true).
 			 */
-			SynchrotronComponentSetSort(const SynchrotronComponentSetSort& sc, bool duplicateAll_IO = false) : SynchrotronComponentSetSort() {
+			SynchrotronComponentSetSort(const SynchrotronComponentSetSort& sc, bool duplicateAll_IO = false) : SynchrotronComponentSetSort(0, sc.get_allocator()) {
 				//LockBlock lock(this);
 
 				// Copy subscriptions
@@ -124,21 +160,60 @@ namespace Synchrotron {
 			 *		When called, will disconnect all in and output connections to this SynchrotronComponentSetSort.
 			 */
 			~SynchrotronComponentSetSort() {
-				LockBlock lock(this);
+				this->disconnectAll([](const SynchrotronComponentSetSort*) { return false; });
+			}
 
-				// Disconnect all Slots
-				for(auto& connection : this->slotOutput) {
-					connection->signalInput.erase(this);
-					//delete connection; //?
-				}
+			/**	\brief	**[Thread safe]** Disconnects all in and outputs, as part of tearing down a whole netlist.
+			 *
+			 *		Only removes this from the connections for which dying(connection) is false.
+			 *		The connections that are destroyed together with this keep their (dangling) pointer to this,
+			 *		which saves erasing every edge from both ends (see Netlist::clear()).
+			 *		Locks this together with every connection that is left, like removeOutput() locks both ends.
+			 *
+			 *	\param	dying
+			 *		Predicate returning whether a connected SynchrotronComponentSetSort is destroyed together with this one.
+			 */
+			template <class Predicate>
+			void disconnectAll(Predicate dying) {
+				std::vector<SynchrotronComponentSetSort*> neighbours, current;
 
-				// Disconnect all Signals
-				for(auto &sender: this->signalInput) {
-					sender->slotOutput.erase(this);
+				auto snapshot = [&](std::vector<SynchrotronComponentSetSort*>& into) {
+					into.clear();
+
+					for(auto& connection : this->slotOutput)
+						if (!dying(connection)) into.push_back(connection);
+
+					for(auto& sender : this->signalInput)
+						if (!dying(sender)) into.push_back(sender);
+				};
+
+				{
+					LockBlock lock(this);
+					snapshot(neighbours);
 				}
 
-				this->slotOutput.clear();
-				this->signalInput.clear();
+				// Lock the neighbours as well, and start over if a connection changed before they were all locked
+				for(;; neighbours.swap(current)) {
+					MultiLockBlock lock(this, neighbours.begin(), neighbours.end());
+					snapshot(current);
+
+					if (current != neighbours)
+						continue;
+
+					for(auto& connection : this->slotOutput) {
+						if (!dying(connection))
+							connection->signalInput.erase(this);
+					}
+
+					for(auto& sender : this->signalInput) {
+						if (!dying(sender))
+							sender->slotOutput.erase(this);
+					}
+
+					this->slotOutput.clear();
+					this->signalInput.clear();
+					return;
+				}
 			}
 
 			/**	\brief	Gets this SynchrotronComponentSetSort's bit width.
@@ -173,24 +248,64 @@ namespace Synchrotron {
 				return this->state;
 			}
 
+			/**	\brief	Gets this SynchrotronComponentSetSort's state by reference, without copying it.
+			 *
+			 *	\return	const std::bitset<bit_width>&
+			 *		Returns the internal bitset, valid as long as this SynchrotronComponentSetSort.
+			 */
+			inline const std::bitset<bit_width>& getStateRef() const {
+				return this->state;
+			}
+
+			/**	\brief	Sets this SynchrotronComponentSetSort's state, without emitting.
+			 *
+			 *	\param	newState
+			 *		The new internal bitset.
+			 */
+			inline void setState(const std::bitset<bit_width>& newState) {
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), this->state, newState);
+				this->state = newState;
+			}
+
 			/**	\brief	Gets the SynchrotronComponentSetSort's input connections.
 			 *
-			 *	\return	std::set<SynchrotronComponentSetSort*>&
+			 *	\return	const connection_container&
 			 *      Returns a reference set to this SynchrotronComponentSetSort's inputs.
 			 */
-			const std::set<SynchrotronComponentSetSort*, Mutex::compare>& getIputs() const {
+			const connection_container& getInputs() const {
 				return this->signalInput;
 			}
 
 			/**	\brief	Gets the SynchrotronComponentSetSort's output connections.
 			 *
-			 *	\return	std::set<SynchrotronComponentSetSort*>&
+			 *	\return	const connection_container&
 			 *      Returns a reference set to this SynchrotronComponentSetSort's outputs.
 			 */
-			const std::set<SynchrotronComponentSetSort*, Mutex::compare>& getOutputs() const {
+			const connection_container& getOutputs() const {
 				return this->slotOutput;
 			}
 
+			/**	\brief	Gets the allocator of the connections.
+			 *
+			 *	\return	Allocator
+			 *		Returns a copy of the allocator this SynchrotronComponentSetSort was constructed with.
+			 */
+			allocator_type get_allocator() const {
+				return allocator_type(this->slotOutput.get_allocator());
+			}
+
+			/**	\brief	Gets the memory used by this SynchrotronComponentSetSort: the object itself (with its lock),
+			 *		and the heap nodes and spare capacity of its connections (see SynchrotronMemory.hpp).
+			 *
+			 *		Not synchronized, like getOutputs().
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of bytes.
+			 */
+			size_t memoryUsage() const {
+				return sizeof(*this) + Memory::heapUsage(this->slotOutput) + Memory::heapUsage(this->signalInput);
+			}
+
 			/**	\brief	Adds/Connects a new input to this SynchrotronComponentSetSort.
 			 *
 			 *	**Ensures both way connection will be made:**
@@ -200,22 +315,42 @@ namespace Synchrotron {
 			 *		The SynchrotronComponentSetSort to connect as input.
 			 */
 			void addInput(SynchrotronComponentSetSort& input) {
-				LockBlock lock(this);
+				DualLockBlock lock(this, &input);
 
 				// deprecated? //if (!this->hasSameWidth(input)) return false;
 				input.connectSlot(this);
 			}
 
+			/**	\brief	**[Thread safe]** Adds/Connects a range of new inputs to this SynchrotronComponentSetSort.
+			 *
+			 *	The range is sorted in the order of the connections (on ids read once) and duplicates are dropped first,
+			 *	so they are appended instead of searched for one by one.
+			 *	This is locked once for every input after it in the lock order, and each input only while it is connected (see forEachLocked()).
+			 *
+			 *	\param	first, last
+			 *		The range of SynchrotronComponentSetSort* to connect as input.
+			 */
+			template <class InputIt>
+			void addInput(InputIt first, InputIt last) {
+				std::vector<SynchrotronComponentSetSort*> inputs(first, last);
+
+				sortByLockOrder(inputs);
+
+				forEachLocked(this, inputs.begin(), inputs.end(), [this](SynchrotronComponentSetSort* input) {
+					input->slotOutput.insert(input->slotOutput.end(), this);
+					this->signalInput.insert(this->signalInput.end(), input);
+				});
+			}
+
 			/**	\brief	Adds/Connects a list of new inputs to this SynchrotronComponent.
 			 *
-			 *	Calls addInput() on each SynchrotronComponent* in inputList.
+			 *	Same as addInput(first, last).
 			 *
 			 *	\param	inputList
 			 *		The list of SynchrotronComponents to connect as input.
 			 */
 			void addInput(std::initializer_list<SynchrotronComponentSetSort*> inputList) {
-				for(auto connection : inputList)
-					this->addInput(*connection);
+				this->addInput(inputList.begin(), inputList.end());
 			}
 
 			/**	\brief	Removes/Disconnects an input to this SynchrotronComponentSetSort.
@@ -227,7 +362,7 @@ namespace Synchrotron {
 			 *		The SynchrotronComponentSetSort to disconnect as input.
 			 */
 			void removeInput(SynchrotronComponentSetSort& input) {
-				LockBlock lock(this);
+				DualLockBlock lock(this, &input);
 
 				input.disconnectSlot(this);
 			}
@@ -241,22 +376,42 @@ namespace Synchrotron {
 			 *		The SynchrotronComponentSetSort to connect as output.
 			 */
 			void addOutput(SynchrotronComponentSetSort& output) {
-				LockBlock lock(this);
+				DualLockBlock lock(this, &output);
 
 				// deprecated? //if (!this->hasSameWidth(*output)) return false;
 				this->connectSlot(&output);
 			}
 
+			/**	\brief	**[Thread safe]** Adds/Connects a range of new outputs to this SynchrotronComponentSetSort.
+			 *
+			 *	The range is sorted in the order of the connections (on ids read once) and duplicates are dropped first,
+			 *	so they are appended instead of searched for one by one.
+			 *	This is locked once for every output after it in the lock order, and each output only while it is connected (see forEachLocked()).
+			 *
+			 *	\param	first, last
+			 *		The range of SynchrotronComponentSetSort* to connect as output.
+			 */
+			template <class InputIt>
+			void addOutput(InputIt first, InputIt last) {
+				std::vector<SynchrotronComponentSetSort*> outputs(first, last);
+
+				sortByLockOrder(outputs);
+
+				forEachLocked(this, outputs.begin(), outputs.end(), [this](SynchrotronComponentSetSort* output) {
+					this->slotOutput.insert(this->slotOutput.end(), output);
+					output->signalInput.insert(output->signalInput.end(), this);
+				});
+			}
+
 			/**	\brief	Adds/Connects a list of new outputs to this SynchrotronComponent.
 			 *
-			 *	Calls addOutput() on each SynchrotronComponent* in outputList.
+			 *	Same as addOutput(first, last).
 			 *
 			 *	\param	outputList
 			 *		The list of SynchrotronComponents to connect as output.
 			 */
 			void addOutput(std::initializer_list<SynchrotronComponentSetSort*> outputList) {
-				for(auto connection : outputList)
-					this->addOutput(*connection);
+				this->addOutput(outputList.begin(), outputList.end());
 			}
 
 			/**	\brief	Removes/Disconnects an output to this SynchrotronComponentSetSort.
@@ -268,11 +423,42 @@ namespace Synchrotron {
 			 *		The SynchrotronComponentSetSort to disconnect as output.
 			 */
 			void removeOutput(SynchrotronComponentSetSort& output) {
-				LockBlock lock(this);
+				DualLockBlock lock(this, &output);
 
 				this->disconnectSlot(&output);
 			}
 
+			/**	\brief	Computes the state this SynchrotronComponentSetSort would get from its inputs, without applying it.
+			 *
+			 *	\return	virtual std::bitset<bit_width>
+			 *		Reduces the inputs with CombinePolicy, a derived class can re-implement this
+			 *		for logic that doesn't fit a policy.
+			 */
+			virtual std::bitset<bit_width> evaluate() const {
+				SYNCHROTRON_STATS_EVALUATE(this->signalInput.size());
+
+				return CombinePolicy::reduce(this->state, this->signalInput.begin(), this->signalInput.end(),
+											 [](const SynchrotronComponentSetSort* connection) -> const std::bitset<bit_width>& { return connection->getStateRef(); });
+			}
+
+			/**	\brief	Applies evaluate() to this SynchrotronComponentSetSort's state, without emitting.
+			 *
+			 *	Used by tick() and by the iterative Scheduler to propagate without recursion.
+			 *
+			 *	\return	bool
+			 *		Returns whether the state has changed.
+			 */
+			bool update() {
+				std::bitset<bit_width> prevState = this->state;
+
+				this->state = this->evaluate();
+
+				SYNCHROTRON_STATS_TICK(prevState != this->state);
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), prevState, this->state);
+
+				return prevState != this->state;
+			}
+
 			/**	\brief	The tick() method will be called when one of this SynchrotronComponentSetSort's inputs issues an emit().
 			 *
 			 *	\return	virtual void
@@ -280,31 +466,64 @@ namespace Synchrotron {
 			 */
 			virtual void tick() {
 				//LockBlock lock(this);
-				std::bitset<bit_width> prevState = this->state;
 
 				//std::cout << "Ticked\n";
-				for(auto& connection : this->signalInput) {
-					// Change this line to change the logic applied on the states:
-					this->state |= ((SynchrotronComponentSetSort*) connection)->getState();
-				}
+				// Directly emit changes to subscribers on change
+				if (this->update())
+					this->emit();
+			}
+
+			/**	\brief	The tick(source) method will be called when source, one of this SynchrotronComponentSetSort's inputs, issues an emit().
+			 *
+			 *	\param	source
+			 *		The input that emitted.
+			 *
+			 *	\return	virtual void
+			 *		Calls tick(), so a derived class re-implementing tick() or evaluate() keeps working.
+			 *		Incremental<SynchrotronComponentSetSort> re-implements it to merge only source (see SynchrotronCombine.hpp).
+			 */
+			virtual void tick(SynchrotronComponentSetSort& source) {
+				(void) source;
+				this->tick();
+			}
+
+		protected:
+			/**	\brief	Merges only the state of source and emits on change, at O(1) instead of O(fan-in) per input event.
+			 *
+			 *	Only gives the same state as tick() if CombinePolicy is incremental (e.g. OR, which is monotone)
+			 *	and the state already holds every other input, i.e. it was tick()ed since they were connected.
+			 *
+			 *	\param	source
+			 *		The input that emitted.
+			 */
+			void tickMerge(const SynchrotronComponentSetSort& source) {
+				//LockBlock lock(this);
+				std::bitset<bit_width> prevState = this->state;
+
+				CombinePolicy::merge(this->state, source.getStateRef());
+				SYNCHROTRON_STATS_TICK(prevState != this->state);
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), prevState, this->state);
 
 				// Directly emit changes to subscribers on change
 				if (prevState != this->state)
 					this->emit();
 			}
 
+		public:
+
 			/**	\brief	The emit() method will be called after a tick() completes to ensure the flow of new data.
 			 *
-			 *	Loops over all outputs and calls tick().
+			 *	Loops over all outputs and calls tick(*this).
 			 *
 			 *	\return	virtual void
 			 *		This method can be re-implemented by a derived class.
 			 */
 			virtual inline void emit() {
 				//LockBlock lock(this);
+				SYNCHROTRON_STATS_EMIT(this->slotOutput.size());
 
 				for(auto& connection : this->slotOutput) {
-					connection->tick();
+					connection->tick(*this);
 				}
 				//std::cout << "Emitted\n";
 			}
@@ -0,0 +1,552 @@
+#ifndef SYNCHROTRONCOMPONENTSMALLSET_HPP
+#define SYNCHROTRONCOMPONENTSMALLSET_HPP
+
+#include <iostream> // For testing for now
+
+#include "SynchrotronComponent.hpp"
+#include "SynchrotronSmallSet.hpp"
+#include <algorithm>
+#include <bitset>
+#include <memory>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	SynchrotronComponent is the base for all components,
+	 *	offering in and output connections to other SynchrotronComponent.
+	 *
+	 *	Keeps its connections in a SmallSet: sorted by `Mutex::compare` and without duplicates
+	 *	like SynchrotronComponentSetSort, but without a heap allocation per connection.
+	 *	Connecting out of order and disconnecting are O(n) in the amount of connections though,
+	 *	so it is meant for gates with a small fan-in and fan-out.
+	 *
+	 *	\param	bit_width
+	 *		This template argument specifies the width of the internal bitset state.
+	 *	\param	CombinePolicy
+	 *		This template argument specifies the logic applied on the input states (see SynchrotronCombine.hpp).
+	 *	\param	LockPolicy
+	 *		This template argument specifies the lock: NoLock, SpinLock or StdMutexLock (see SynchrotronLock.hpp).
+	 *	\param	inline_edges
+	 *		This template argument specifies the amount of in and outputs that are stored inline,
+	 *		without a heap allocation (see SynchrotronSmallSet.hpp).
+	 *	\param	Allocator
+	 *		This template argument specifies the allocator of the connections, e.g. an ArenaAllocator (see SynchrotronArena.hpp).
+	 *	\param	StatePolicy
+	 *		This template argument specifies where the state is kept: InlineState, or ExternalState for the StateArray of a Netlist (see SynchrotronStateArray.hpp).
+	 */
+	template <size_t bit_width, class CombinePolicy = OrPolicy, class LockPolicy = StdMutexLock, size_t inline_edges = 4, class Allocator = std::allocator<void*>, class StatePolicy = InlineState>
+	class SynchrotronComponentSmallSet : public BasicMutex<LockPolicy>, public StatePolicy::template storage<std::bitset<bit_width>> {
+		private:
+			typedef BasicLockBlock<BasicMutex<LockPolicy>> LockBlock;
+			typedef BasicDualLockBlock<BasicMutex<LockPolicy>> DualLockBlock;
+			typedef BasicMultiLockBlock<BasicMutex<LockPolicy>> MultiLockBlock;
+			typedef typename std::allocator_traits<Allocator>::template rebind_alloc<SynchrotronComponentSmallSet*> connection_allocator;
+
+		public:
+			typedef Allocator allocator_type;
+			typedef SmallSet<SynchrotronComponentSmallSet*, inline_edges, Mutex::compare, connection_allocator> connection_container;
+
+		private:
+			/**	\brief
+			 *	**Slots == outputs**
+			 *
+			 *		Emit this.signal to subscribers in slotOutput.
+			 */
+			connection_container slotOutput;
+
+			/**	\brief
+			 *	**Signals == inputs**
+			 *
+			 *		Receive tick()s from these subscriptions in signalInput.
+			 */
+			connection_container signalInput;
+
+			/**	\brief	Connect a new slot s:
+			 *		* Add s to this SynchrotronComponentSmallSet's outputs.
+			 *		* Add this to s's inputs.
+			 *
+			 *	\param	s
+			 *		The SynchrotronComponentSmallSet to connect.
+			 */
+			inline void connectSlot(SynchrotronComponentSmallSet* s) {
+				//LockBlock lock(this);
+
+				this->slotOutput.insert(s);
+				s->signalInput.insert(this);
+			}
+
+			/**	\brief	Disconnect a slot s:
+			 *		* Remove s from this SynchrotronComponentSmallSet's outputs.
+			 *		* Remove this from s's inputs.
+			 *
+			 *	\param	s
+			 *		The SynchrotronComponentSmallSet to disconnect.
+			 */
+			inline void disconnectSlot(SynchrotronComponentSmallSet* s) {
+				//LockBlock lock(this);
+
+				this->slotOutput.erase(s);
+				s->signalInput.erase(this);
+			}
+
+		public:
+			typedef CombinePolicy combine_policy;
+
+			/** \brief	Default constructor
+			 *
+			 *	\param	initial_value
+			 *		The initial state of the internal bitset.
+			 *	\param	alloc
+			 *		The allocator for the connections.
+			 *	\param	bit_width
+			 *		The size of the internal width of the bitset.
+			 */
+			SynchrotronComponentSmallSet(size_t initial_value = 0, const Allocator& alloc = Allocator())
+				: StatePolicy::template storage<std::bitset<bit_width>>(initial_value), slotOutput(connection_allocator(alloc)), signalInput(connection_allocator(alloc)) {}
+
+			/** \brief	State storage constructor, keeps the state in storage instead of in this SynchrotronComponentSmallSet.
+			 *
+			 *		Only if StatePolicy is ExternalState.
+			 *
+			 *	\param	storage
+			 *		Where to keep the state, must outlive this SynchrotronComponentSmallSet (e.g. a slot of a StateArray).
+			 *	\param	initial_value
+			 *		The initial state of the internal bitset.
+			 *	\param	alloc
+			 *		The allocator for the connections.
+			 */
+			template <class S = StatePolicy, class = typename std::enable_if<S::external>::type>
+			SynchrotronComponentSmallSet(std::bitset<bit_width>& storage, size_t initial_value = 0, const Allocator& alloc = Allocator())
+				: StatePolicy::template storage<std::bitset<bit_width>>(storage, initial_value), slotOutput(connection_allocator(alloc)), signalInput(connection_allocator(alloc)) {}
+
+			/**	\brief
+			 *	Copy constructor
+			 *	*	Duplicates signal subscriptions (inputs)
+			 *	*	Optionally also duplicates slot connections (outputs)
+			 *
+			 *	\param	sc const
+			 *		The other SynchrotronComponentSmallSet to duplicate the connections from.
+			 *	\param	duplicateAll_IO
+			 *		Specifies whether to only copy inputs (false) or outputs as well (true).
+			 */
+			SynchrotronComponentSmallSet(const SynchrotronComponentSmallSet& sc, bool duplicateAll_IO = false) : SynchrotronComponentSmallSet(0, sc.get_allocator()) {
+				//LockBlock lock(this);
+
+				// Copy subscriptions
+				for(auto& sender : sc.signalInput) {
+					this->addInput(*sender);
+				}
+
+				if (duplicateAll_IO) {
+					// Copy subscribers
+					for(auto& connection : sc.slotOutput) {
+						this->addOutput(*connection);
+					}
+				}
+			}
+
+			/**	\brief
+			 *	Connection constructor
+			 *	*	Adds signal subscriptions from inputList
+			 *	*	Optionally adds slot subscribers from outputList
+			 *
+			 *	\param	inputList
+			 *		The list of SynchrotronComponents to connect as input.
+			 *	\param	outputList
+			 *		The list of SynchrotronComponents to connect as output..
+			 */
+			SynchrotronComponentSmallSet(std::initializer_list<SynchrotronComponentSmallSet*> inputList,
+								 std::initializer_list<SynchrotronComponentSmallSet*> outputList = {})
+									: SynchrotronComponentSmallSet() {
+				this->addInput(inputList);
+				this->addOutput(outputList);
+			}
+
+			/** \brief	Default destructor
+			 *
+			 *		When called, will disconnect all in and output connections to this SynchrotronComponentSmallSet.
+			 */
+			~SynchrotronComponentSmallSet() {
+				this->disconnectAll([](const SynchrotronComponentSmallSet*) { return false; });
+			}
+
+			/**	\brief	**[Thread safe]** Disconnects all in and outputs, as part of tearing down a whole netlist.
+			 *
+			 *		Only removes this from the connections for which dying(connection) is false.
+			 *		The connections that are destroyed together with this keep their (dangling) pointer to this,
+			 *		which saves erasing every edge from both ends (see Netlist::clear()).
+			 *		Locks this together with every connection that is left, like removeOutput() locks both ends.
+			 *
+			 *	\param	dying
+			 *		Predicate returning whether a connected SynchrotronComponentSmallSet is destroyed together with this one.
+			 */
+			template <class Predicate>
+			void disconnectAll(Predicate dying) {
+				std::vector<SynchrotronComponentSmallSet*> neighbours, current;
+
+				auto snapshot = [&](std::vector<SynchrotronComponentSmallSet*>& into) {
+					into.clear();
+
+					for(auto& connection : this->slotOutput)
+						if (!dying(connection)) into.push_back(connection);
+
+					for(auto& sender : this->signalInput)
+						if (!dying(sender)) into.push_back(sender);
+				};
+
+				{
+					LockBlock lock(this);
+					snapshot(neighbours);
+				}
+
+				// Lock the neighbours as well, and start over if a connection changed before they were all locked
+				for(;; neighbours.swap(current)) {
+					MultiLockBlock lock(this, neighbours.begin(), neighbours.end());
+					snapshot(current);
+
+					if (current != neighbours)
+						continue;
+
+					for(auto& connection : this->slotOutput) {
+						if (!dying(connection))
+							connection->signalInput.erase(this);
+					}
+
+					for(auto& sender : this->signalInput) {
+						if (!dying(sender))
+							sender->slotOutput.erase(this);
+					}
+
+					this->slotOutput.clear();
+					this->signalInput.clear();
+					return;
+				}
+			}
+
+			/**	\brief	Gets this SynchrotronComponentSmallSet's bit width.
+			 *
+			 *	\return	size_t
+			 *      Returns the bit width of the internal bitset.
+			 */
+			size_t getBitWidth() const {
+				return bit_width;
+			}
+
+//			/* No real use since function cannot be called with different size SynchrotronComponentSmallSets */
+//			/* Maybe viable when SynchrotronComponentSmallSet has different in and output sizes */
+//			/*	\brief	Compare this bit width to that of other.
+//             *
+//             *	\param	other
+//			 *		The other SynchrotronComponentSmallSet to check.
+//			 *
+//             *	\return	bool
+//             *      Returns whether the widths match.
+//             */
+//			inline bool hasSameWidth(SynchrotronComponentSmallSet& other) {
+//				return this->getBitWidth() == other.getBitWidth();
+//			}
+
+			/**	\brief	Gets this SynchrotronComponentSmallSet's state.
+			 *
+			 *	\return	std::bitset<bit_width>
+			 *      Returns the internal bitset.
+			 */
+			inline std::bitset<bit_width> getState() const {
+				return this->state;
+			}
+
+			/**	\brief	Gets this SynchrotronComponentSmallSet's state by reference, without copying it.
+			 *
+			 *	\return	const std::bitset<bit_width>&
+			 *		Returns the internal bitset, valid as long as this SynchrotronComponentSmallSet.
+			 */
+			inline const std::bitset<bit_width>& getStateRef() const {
+				return this->state;
+			}
+
+			/**	\brief	Sets this SynchrotronComponentSmallSet's state, without emitting.
+			 *
+			 *	\param	newState
+			 *		The new internal bitset.
+			 */
+			inline void setState(const std::bitset<bit_width>& newState) {
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), this->state, newState);
+				this->state = newState;
+			}
+
+			/**	\brief	Gets the SynchrotronComponentSmallSet's input connections.
+			 *
+			 *	\return	const connection_container&
+			 *      Returns a reference set to this SynchrotronComponentSmallSet's inputs.
+			 */
+			const connection_container& getInputs() const {
+				return this->signalInput;
+			}
+
+			/**	\brief	Gets the SynchrotronComponentSmallSet's output connections.
+			 *
+			 *	\return	const connection_container&
+			 *      Returns a reference set to this SynchrotronComponentSmallSet's outputs.
+			 */
+			const connection_container& getOutputs() const {
+				return this->slotOutput;
+			}
+
+			/**	\brief	Gets the allocator of the connections.
+			 *
+			 *	\return	Allocator
+			 *		Returns a copy of the allocator this SynchrotronComponentSmallSet was constructed with.
+			 */
+			allocator_type get_allocator() const {
+				return allocator_type(this->slotOutput.get_allocator());
+			}
+
+			/**	\brief	Gets the memory used by this SynchrotronComponentSmallSet: the object itself (with its lock),
+			 *		and the heap nodes and spare capacity of its connections (see SynchrotronMemory.hpp).
+			 *
+			 *		Not synchronized, like getOutputs().
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of bytes.
+			 */
+			size_t memoryUsage() const {
+				return sizeof(*this) + Memory::heapUsage(this->slotOutput) + Memory::heapUsage(this->signalInput);
+			}
+
+			/**	\brief	Adds/Connects a new input to this SynchrotronComponentSmallSet.
+			 *
+			 *	**Ensures both way connection will be made:**
+			 *	This will have input added to its inputs and input will have this added to its outputs.
+			 *
+			 *	\param	input
+			 *		The SynchrotronComponentSmallSet to connect as input.
+			 */
+			void addInput(SynchrotronComponentSmallSet& input) {
+				DualLockBlock lock(this, &input);
+
+				// deprecated? //if (!this->hasSameWidth(input)) return false;
+				input.connectSlot(this);
+			}
+
+			/**	\brief	**[Thread safe]** Adds/Connects a range of new inputs to this SynchrotronComponentSmallSet.
+			 *
+			 *	The range is sorted in the order of the connections (on ids read once) and duplicates are dropped first,
+			 *	so they are appended instead of searched for one by one.
+			 *	This is locked once for every input after it in the lock order, and each input only while it is connected (see forEachLocked()).
+			 *
+			 *	\param	first, last
+			 *		The range of SynchrotronComponentSmallSet* to connect as input.
+			 */
+			template <class InputIt>
+			void addInput(InputIt first, InputIt last) {
+				std::vector<SynchrotronComponentSmallSet*> inputs(first, last);
+
+				sortByLockOrder(inputs);
+
+				{
+					LockBlock lock(this);
+					this->signalInput.reserve(this->signalInput.size() + inputs.size());
+				}
+
+				forEachLocked(this, inputs.begin(), inputs.end(), [this](SynchrotronComponentSmallSet* input) {
+					input->slotOutput.insert(this);
+					this->signalInput.insert(this->signalInput.end(), input);
+				});
+			}
+
+			/**	\brief	Adds/Connects a list of new inputs to this SynchrotronComponent.
+			 *
+			 *	Same as addInput(first, last).
+			 *
+			 *	\param	inputList
+			 *		The list of SynchrotronComponents to connect as input.
+			 */
+			void addInput(std::initializer_list<SynchrotronComponentSmallSet*> inputList) {
+				this->addInput(inputList.begin(), inputList.end());
+			}
+
+			/**	\brief	Removes/Disconnects an input to this SynchrotronComponentSmallSet.
+			 *
+			 *	**Ensures both way connection will be removed:**
+			 *	This will have input removed from its inputs and input will have this removed from its outputs.
+			 *
+			 *	\param	input
+			 *		The SynchrotronComponentSmallSet to disconnect as input.
+			 */
+			void removeInput(SynchrotronComponentSmallSet& input) {
+				DualLockBlock lock(this, &input);
+
+				input.disconnectSlot(this);
+			}
+
+			/**	\brief	Adds/Connects a new output to this SynchrotronComponentSmallSet.
+			 *
+			 *	**Ensures both way connection will be made:**
+			 *	This will have output added to its outputs and output will have this added to its inputs.
+			 *
+			 *	\param	output
+			 *		The SynchrotronComponentSmallSet to connect as output.
+			 */
+			void addOutput(SynchrotronComponentSmallSet& output) {
+				DualLockBlock lock(this, &output);
+
+				// deprecated? //if (!this->hasSameWidth(*output)) return false;
+				this->connectSlot(&output);
+			}
+
+			/**	\brief	**[Thread safe]** Adds/Connects a range of new outputs to this SynchrotronComponentSmallSet.
+			 *
+			 *	The range is sorted in the order of the connections (on ids read once) and duplicates are dropped first,
+			 *	so they are appended instead of searched for one by one.
+			 *	This is locked once for every output after it in the lock order, and each output only while it is connected (see forEachLocked()).
+			 *
+			 *	\param	first, last
+			 *		The range of SynchrotronComponentSmallSet* to connect as output.
+			 */
+			template <class InputIt>
+			void addOutput(InputIt first, InputIt last) {
+				std::vector<SynchrotronComponentSmallSet*> outputs(first, last);
+
+				sortByLockOrder(outputs);
+
+				{
+					LockBlock lock(this);
+					this->slotOutput.reserve(this->slotOutput.size() + outputs.size());
+				}
+
+				forEachLocked(this, outputs.begin(), outputs.end(), [this](SynchrotronComponentSmallSet* output) {
+					this->slotOutput.insert(this->slotOutput.end(), output);
+					output->signalInput.insert(this);
+				});
+			}
+
+			/**	\brief	Adds/Connects a list of new outputs to this SynchrotronComponent.
+			 *
+			 *	Same as addOutput(first, last).
+			 *
+			 *	\param	outputList
+			 *		The list of SynchrotronComponents to connect as output.
+			 */
+			void addOutput(std::initializer_list<SynchrotronComponentSmallSet*> outputList) {
+				this->addOutput(outputList.begin(), outputList.end());
+			}
+
+			/**	\brief	Removes/Disconnects an output to this SynchrotronComponentSmallSet.
+			 *
+			 *	**Ensures both way connection will be removed:**
+			 *	This will have output removed from its output and output will have this removed from its inputs.
+			 *
+			 *	\param	output
+			 *		The SynchrotronComponentSmallSet to disconnect as output.
+			 */
+			void removeOutput(SynchrotronComponentSmallSet& output) {
+				DualLockBlock lock(this, &output);
+
+				this->disconnectSlot(&output);
+			}
+
+			/**	\brief	Computes the state this SynchrotronComponentSmallSet would get from its inputs, without applying it.
+			 *
+			 *	\return	virtual std::bitset<bit_width>
+			 *		Reduces the inputs with CombinePolicy, a derived class can re-implement this
+			 *		for logic that doesn't fit a policy.
+			 */
+			virtual std::bitset<bit_width> evaluate() const {
+				SYNCHROTRON_STATS_EVALUATE(this->signalInput.size());
+
+				return CombinePolicy::reduce(this->state, this->signalInput.begin(), this->signalInput.end(),
+											 [](const SynchrotronComponentSmallSet* connection) -> const std::bitset<bit_width>& { return connection->getStateRef(); });
+			}
+
+			/**	\brief	Applies evaluate() to this SynchrotronComponentSmallSet's state, without emitting.
+			 *
+			 *	Used by tick() and by the iterative Scheduler to propagate without recursion.
+			 *
+			 *	\return	bool
+			 *		Returns whether the state has changed.
+			 */
+			bool update() {
+				std::bitset<bit_width> prevState = this->state;
+
+				this->state = this->evaluate();
+
+				SYNCHROTRON_STATS_TICK(prevState != this->state);
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), prevState, this->state);
+
+				return prevState != this->state;
+			}
+
+			/**	\brief	The tick() method will be called when one of this SynchrotronComponentSmallSet's inputs issues an emit().
+			 *
+			 *	\return	virtual void
+			 *		This method should be implemented by a derived class.
+			 */
+			virtual void tick() {
+				//LockBlock lock(this);
+
+				//std::cout << "Ticked\n";
+				// Directly emit changes to subscribers on change
+				if (this->update())
+					this->emit();
+			}
+
+			/**	\brief	The tick(source) method will be called when source, one of this SynchrotronComponentSmallSet's inputs, issues an emit().
+			 *
+			 *	\param	source
+			 *		The input that emitted.
+			 *
+			 *	\return	virtual void
+			 *		Calls tick(), so a derived class re-implementing tick() or evaluate() keeps working.
+			 *		Incremental<SynchrotronComponentSmallSet> re-implements it to merge only source (see SynchrotronCombine.hpp).
+			 */
+			virtual void tick(SynchrotronComponentSmallSet& source) {
+				(void) source;
+				this->tick();
+			}
+
+		protected:
+			/**	\brief	Merges only the state of source and emits on change, at O(1) instead of O(fan-in) per input event.
+			 *
+			 *	Only gives the same state as tick() if CombinePolicy is incremental (e.g. OR, which is monotone)
+			 *	and the state already holds every other input, i.e. it was tick()ed since they were connected.
+			 *
+			 *	\param	source
+			 *		The input that emitted.
+			 */
+			void tickMerge(const SynchrotronComponentSmallSet& source) {
+				//LockBlock lock(this);
+				std::bitset<bit_width> prevState = this->state;
+
+				CombinePolicy::merge(this->state, source.getStateRef());
+				SYNCHROTRON_STATS_TICK(prevState != this->state);
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), prevState, this->state);
+
+				// Directly emit changes to subscribers on change
+				if (prevState != this->state)
+					this->emit();
+			}
+
+		public:
+
+			/**	\brief	The emit() method will be called after a tick() completes to ensure the flow of new data.
+			 *
+			 *	Loops over all outputs and calls tick(*this).
+			 *
+			 *	\return	virtual void
+			 *		This method can be re-implemented by a derived class.
+			 */
+			virtual inline void emit() {
+				//LockBlock lock(this);
+				SYNCHROTRON_STATS_EMIT(this->slotOutput.size());
+
+				for(auto& connection : this->slotOutput) {
+					connection->tick(*this);
+				}
+				//std::cout << "Emitted\n";
+			}
+	};
+}
+
+
+#endif // SYNCHROTRONCOMPONENTSMALLSET_HPP
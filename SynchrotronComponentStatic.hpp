@@ -0,0 +1,380 @@
+#ifndef SYNCHROTRONCOMPONENTSTATIC_HPP
+#define SYNCHROTRONCOMPONENTSTATIC_HPP
+
+#include "SynchrotronCombine.hpp"
+#include "SynchrotronLock.hpp"
+#include "SynchrotronMemory.hpp"
+#include "SynchrotronStats.hpp"
+#include "SynchrotronTrace.hpp"
+#include <bitset>
+#include <set>
+#include <vector>
+#include <initializer_list>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	SynchrotronComponentBase is the statically polymorphic (CRTP) counterpart of SynchrotronComponent.
+	 *
+	 *	Nothing in here is virtual: tick(), emit(), evaluate() and update() are always called
+	 *	through Derived, so a derived gate "re-implements" them by hiding them,
+	 *	and the compiler can inline whole emit() -> tick() chains.
+	 *	Locking is non-virtual as well and selected by LockPolicy.
+	 *	The connections are ordered by `MutexId::compare`, like in SynchrotronComponentSetSort.
+	 *
+	 *	Since there is no common virtual base, only Components of the same Derived type can be connected.
+	 *
+	 *	\param	Derived
+	 *		The class deriving from this one.
+	 *	\param	bit_width
+	 *		This template argument specifies the width of the internal bitset state.
+	 *	\param	CombinePolicy
+	 *		This template argument specifies the logic applied on the input states (see SynchrotronCombine.hpp).
+	 *	\param	LockPolicy
+	 *		This template argument specifies the lock: NoLock, SpinLock or StdMutexLock (see SynchrotronLock.hpp).
+	 */
+	template <class Derived, size_t bit_width, class CombinePolicy = OrPolicy, class LockPolicy = NoLock>
+	class SynchrotronComponentBase : public BasicMutex<LockPolicy> {
+		private:
+			typedef BasicLockBlock<BasicMutex<LockPolicy>> LockBlock;
+			typedef BasicDualLockBlock<BasicMutex<LockPolicy>> DualLockBlock;
+			typedef BasicMultiLockBlock<BasicMutex<LockPolicy>> MultiLockBlock;
+
+		protected:
+			/**	\brief
+			 *	The current internal state of bits in this component (default output).
+			 */
+			std::bitset<bit_width> state;
+
+		private:
+			/**	\brief
+			 *	**Slots == outputs**
+			 *
+			 *		Emit this.signal to subscribers in slotOutput.
+			 */
+			std::set<Derived*, MutexId::compare> slotOutput;
+
+			/**	\brief
+			 *	**Signals == inputs**
+			 *
+			 *		Receive tick()s from these subscriptions in signalInput.
+			 */
+			std::set<Derived*, MutexId::compare> signalInput;
+
+			inline Derived& derived()				{ return static_cast<Derived&>(*this);			}
+			inline const Derived& derived() const	{ return static_cast<const Derived&>(*this);	}
+
+			/**	\brief	Connect a new slot s:
+			 *		* Add s to this SynchrotronComponentBase's outputs.
+			 *		* Add this to s's inputs.
+			 *
+			 *	\param	s
+			 *		The Derived to connect.
+			 */
+			inline void connectSlot(Derived* s) {
+				this->slotOutput.insert(this->slotOutput.end(), s);
+				s->signalInput.insert(s->signalInput.end(), &this->derived());
+			}
+
+			/**	\brief	Disconnect a slot s:
+			 *		* Remove s from this SynchrotronComponentBase's outputs.
+			 *		* Remove this from s's inputs.
+			 *
+			 *	\param	s
+			 *		The Derived to disconnect.
+			 */
+			inline void disconnectSlot(Derived* s) {
+				this->slotOutput.erase(s);
+				s->signalInput.erase(&this->derived());
+			}
+
+		protected:
+			/** \brief	Default constructor, only to be used by Derived.
+			 *
+			 *	\param	initial_value
+			 *		The initial state of the internal bitset.
+			 */
+			SynchrotronComponentBase(size_t initial_value = 0) : state(initial_value) {}
+
+			/** \brief	Default destructor, not virtual: a Derived should never be deleted through this base.
+			 *
+			 *		When called, will disconnect all in and output connections to this SynchrotronComponentBase.
+			 */
+			~SynchrotronComponentBase() {
+				std::vector<Derived*> neighbours, current;
+
+				auto snapshot = [this](std::vector<Derived*>& into) {
+					into.assign(this->slotOutput.begin(), this->slotOutput.end());
+					into.insert(into.end(), this->signalInput.begin(), this->signalInput.end());
+				};
+
+				{
+					LockBlock lock(this);
+					snapshot(neighbours);
+				}
+
+				// Lock the neighbours as well, and start over if a connection changed before they were all locked
+				for(;; neighbours.swap(current)) {
+					MultiLockBlock lock(this, neighbours.begin(), neighbours.end());
+					snapshot(current);
+
+					if (current != neighbours)
+						continue;
+
+					for(auto& connection : this->slotOutput) {
+						connection->signalInput.erase(&this->derived());
+					}
+
+					for(auto& sender : this->signalInput) {
+						sender->slotOutput.erase(&this->derived());
+					}
+
+					this->slotOutput.clear();
+					this->signalInput.clear();
+					return;
+				}
+			}
+
+		public:
+			typedef CombinePolicy combine_policy;
+
+			/**	\brief
+			 *	Whether tick(source) merges only the state of source, hidden by a Derived that opts in.
+			 */
+			static const bool incremental_tick = false;
+
+			SynchrotronComponentBase(const SynchrotronComponentBase&) = delete;
+			SynchrotronComponentBase& operator=(const SynchrotronComponentBase&) = delete;
+
+			/**	\brief	Gets this SynchrotronComponentBase's bit width.
+			 *
+			 *	\return	size_t
+			 *      Returns the bit width of the internal bitset.
+			 */
+			size_t getBitWidth() const {
+				return bit_width;
+			}
+
+			/**	\brief	Gets this SynchrotronComponentBase's state.
+			 *
+			 *	\return	std::bitset<bit_width>
+			 *      Returns the internal bitset.
+			 */
+			inline std::bitset<bit_width> getState() const {
+				return this->state;
+			}
+
+			/**	\brief	Gets this SynchrotronComponentBase's state by reference, without copying it.
+			 *
+			 *	\return	const std::bitset<bit_width>&
+			 *		Returns the internal bitset, valid as long as this SynchrotronComponentBase.
+			 */
+			inline const std::bitset<bit_width>& getStateRef() const {
+				return this->state;
+			}
+
+			/**	\brief	Sets this SynchrotronComponentBase's state, without emitting.
+			 *
+			 *	\param	newState
+			 *		The new internal bitset.
+			 */
+			inline void setState(const std::bitset<bit_width>& newState) {
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), this->state, newState);
+				this->state = newState;
+			}
+
+			/**	\brief	Gets the SynchrotronComponentBase's input connections.
+			 *
+			 *	\return	std::set<Derived*, MutexId::compare>&
+			 *      Returns a reference set to this SynchrotronComponentBase's inputs.
+			 */
+			const std::set<Derived*, MutexId::compare>& getInputs() const {
+				return this->signalInput;
+			}
+
+			/**	\brief	Gets the SynchrotronComponentBase's output connections.
+			 *
+			 *	\return	std::set<Derived*, MutexId::compare>&
+			 *      Returns a reference set to this SynchrotronComponentBase's outputs.
+			 */
+			const std::set<Derived*, MutexId::compare>& getOutputs() const {
+				return this->slotOutput;
+			}
+
+			/**	\brief	Gets the memory used by this Derived: the object itself (with its lock),
+			 *		and the heap nodes of its connections (see SynchrotronMemory.hpp).
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of bytes.
+			 */
+			size_t memoryUsage() const {
+				return sizeof(Derived) + Memory::heapUsage(this->slotOutput) + Memory::heapUsage(this->signalInput);
+			}
+
+			/**	\brief	Adds/Connects a new input to this SynchrotronComponentBase.
+			 *
+			 *	\param	input
+			 *		The Derived to connect as input.
+			 */
+			void addInput(Derived& input) {
+				DualLockBlock lock(this, &input);
+
+				input.connectSlot(&this->derived());
+			}
+
+			/**	\brief	Adds/Connects a list of new inputs to this SynchrotronComponentBase.
+			 *
+			 *	\param	inputList
+			 *		The list of Derived to connect as input.
+			 */
+			void addInput(std::initializer_list<Derived*> inputList) {
+				for(auto connection : inputList)
+					this->addInput(*connection);
+			}
+
+			/**	\brief	Removes/Disconnects an input to this SynchrotronComponentBase.
+			 *
+			 *	\param	input
+			 *		The Derived to disconnect as input.
+			 */
+			void removeInput(Derived& input) {
+				DualLockBlock lock(this, &input);
+
+				input.disconnectSlot(&this->derived());
+			}
+
+			/**	\brief	Adds/Connects a new output to this SynchrotronComponentBase.
+			 *
+			 *	\param	output
+			 *		The Derived to connect as output.
+			 */
+			void addOutput(Derived& output) {
+				DualLockBlock lock(this, &output);
+
+				this->connectSlot(&output);
+			}
+
+			/**	\brief	Adds/Connects a list of new outputs to this SynchrotronComponentBase.
+			 *
+			 *	\param	outputList
+			 *		The list of Derived to connect as output.
+			 */
+			void addOutput(std::initializer_list<Derived*> outputList) {
+				for(auto connection : outputList)
+					this->addOutput(*connection);
+			}
+
+			/**	\brief	Removes/Disconnects an output to this SynchrotronComponentBase.
+			 *
+			 *	\param	output
+			 *		The Derived to disconnect as output.
+			 */
+			void removeOutput(Derived& output) {
+				DualLockBlock lock(this, &output);
+
+				this->disconnectSlot(&output);
+			}
+
+			/**	\brief	Computes the state this SynchrotronComponentBase would get from its inputs, without applying it.
+			 *
+			 *	\return	std::bitset<bit_width>
+			 *		Reduces the inputs with CombinePolicy, Derived can hide this for other logic.
+			 */
+			inline std::bitset<bit_width> evaluate() const {
+				SYNCHROTRON_STATS_EVALUATE(this->signalInput.size());
+
+				return CombinePolicy::reduce(this->state, this->signalInput.begin(), this->signalInput.end(),
+											 [](const Derived* connection) -> const std::bitset<bit_width>& { return connection->getStateRef(); });
+			}
+
+			/**	\brief	Applies Derived::evaluate() to this SynchrotronComponentBase's state, without emitting.
+			 *
+			 *	\return	bool
+			 *		Returns whether the state has changed.
+			 */
+			inline bool update() {
+				std::bitset<bit_width> prevState = this->state;
+
+				this->state = this->derived().evaluate();
+
+				SYNCHROTRON_STATS_TICK(prevState != this->state);
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), prevState, this->state);
+
+				return prevState != this->state;
+			}
+
+			/**	\brief	Recomputes the state from every input, and emits on change.
+			 */
+			inline void tick() {
+				if (this->derived().update())
+					this->derived().emit();
+			}
+
+			/**	\brief	Called when source, one of this SynchrotronComponentBase's inputs, issues an emit().
+			 *
+			 *	Calls Derived::tick(), so a Derived hiding tick() or evaluate() keeps working.
+			 *	A Derived that hides neither can opt in to merging only the state of source, at O(1) instead of O(fan-in),
+			 *	by hiding `incremental_tick` with true. That only gives the same state as tick() if CombinePolicy
+			 *	is incremental and the state already holds every other input, i.e. it was tick()ed since they were connected.
+			 *
+			 *	\param	source
+			 *		The input that emitted.
+			 */
+			inline void tick(Derived& source) {
+				if (!Derived::incremental_tick) {
+					this->derived().tick();
+					return;
+				}
+
+				static_assert(!Derived::incremental_tick || CombinePolicy::incremental, "incremental_tick requires an incremental CombinePolicy");
+
+				std::bitset<bit_width> prevState = this->state;
+
+				CombinePolicy::merge(this->state, source.getStateRef());
+				SYNCHROTRON_STATS_TICK(prevState != this->state);
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), prevState, this->state);
+
+				if (prevState != this->state)
+					this->derived().emit();
+			}
+
+			/**	\brief	Loops over all outputs and calls tick(*this).
+			 */
+			inline void emit() {
+				SYNCHROTRON_STATS_EMIT(this->slotOutput.size());
+
+				for(auto& connection : this->slotOutput) {
+					connection->tick(this->derived());
+				}
+			}
+	};
+
+	/** \brief
+	 *	SynchrotronComponentStatic is a ready to use SynchrotronComponentBase, for gates
+	 *	that only need a CombinePolicy and no logic of their own.
+	 *
+	 *	\param	bit_width
+	 *		This template argument specifies the width of the internal bitset state.
+	 *	\param	CombinePolicy
+	 *		This template argument specifies the logic applied on the input states (see SynchrotronCombine.hpp).
+	 *	\param	LockPolicy
+	 *		This template argument specifies the lock: NoLock, SpinLock or StdMutexLock (see SynchrotronLock.hpp).
+	 */
+	template <size_t bit_width, class CombinePolicy = OrPolicy, class LockPolicy = NoLock>
+	class SynchrotronComponentStatic final
+		: public SynchrotronComponentBase<SynchrotronComponentStatic<bit_width, CombinePolicy, LockPolicy>,
+										  bit_width, CombinePolicy, LockPolicy> {
+		public:
+			SynchrotronComponentStatic(size_t initial_value = 0)
+				: SynchrotronComponentStatic::SynchrotronComponentBase(initial_value) {}
+
+			SynchrotronComponentStatic(std::initializer_list<SynchrotronComponentStatic*> inputList,
+									   std::initializer_list<SynchrotronComponentStatic*> outputList = {})
+										: SynchrotronComponentStatic() {
+				this->addInput(inputList);
+				this->addOutput(outputList);
+			}
+	};
+}
+
+#endif // SYNCHROTRONCOMPONENTSTATIC_HPP
@@ -5,9 +5,11 @@
 #include <iostream> // For testing for now
 
 #include "SynchrotronComponent.hpp"
+#include "SynchrotronFlatHashSet.hpp"
 #include <bitset>
-#include <vector>
+#include <memory>
 #include <algorithm>
+#include <vector>
 
 namespace Synchrotron {
 
@@ -17,28 +19,41 @@ namespace Synchrotron {
 	 *
 	 *	\param	bit_width
 	 *		This template argument specifies the width of the internal bitset state.
+	 *	\param	CombinePolicy
+	 *		This template argument specifies the logic applied on the input states (see SynchrotronCombine.hpp).
+	 *	\param	LockPolicy
+	 *		This template argument specifies the lock: NoLock, SpinLock or StdMutexLock (see SynchrotronLock.hpp).
+	 *	\param	Allocator
+	 *		This template argument specifies the allocator of the connections, e.g. an ArenaAllocator (see SynchrotronArena.hpp).
+	 *	\param	StatePolicy
+	 *		This template argument specifies where the state is kept: InlineState, or ExternalState for the StateArray of a Netlist (see SynchrotronStateArray.hpp).
 	 */
-	template <size_t bit_width>
-	class SynchrotronComponentVector : public Mutex {
+	template <size_t bit_width, class CombinePolicy = OrPolicy, class LockPolicy = StdMutexLock, class Allocator = std::allocator<void*>, class StatePolicy = InlineState>
+	class SynchrotronComponentVector : public BasicMutex<LockPolicy>, public StatePolicy::template storage<std::bitset<bit_width>> {
 		private:
-			/**	\brief
-			 *	The current internal state of bits in this component (default output).
-			 */
-			std::bitset<bit_width> state;
+			typedef BasicLockBlock<BasicMutex<LockPolicy>> LockBlock;
+			typedef BasicDualLockBlock<BasicMutex<LockPolicy>> DualLockBlock;
+			typedef BasicMultiLockBlock<BasicMutex<LockPolicy>> MultiLockBlock;
+			typedef typename std::allocator_traits<Allocator>::template rebind_alloc<SynchrotronComponentVector*> connection_allocator;
 
+		public:
+			typedef Allocator allocator_type;
+			typedef std::vector<SynchrotronComponentVector*, connection_allocator> connection_container;
+
+		private:
 			/**	\brief
 			 *	**Slots == outputs**
 			 *
 			 *		Emit this.signal to subscribers in slotOutput.
 			 */
-			std::vector<SynchrotronComponentVector*> slotOutput;
+			connection_container slotOutput;
 
 			/**	\brief
 			 *	**Signals == inputs**
 			 *
 			 *		Receive tick()s from these subscriptions in signalInput.
 			 */
-			std::vector<SynchrotronComponentVector*> signalInput;
+			connection_container signalInput;
 
 			/**	\brief	Connect a new slot s:
 			 *		* Add s to this SynchrotronComponent's outputs.
@@ -65,18 +80,38 @@ namespace Synchrotron {
 				//LockBlock lock(this);
 
 				this->slotOutput.erase(std::remove(this->slotOutput.begin(), this->slotOutput.end(), s), this->slotOutput.end());
-				s->signalInput.erase(std::remove(this->signalInput.begin(), this->signalInput.end(), s), this->signalInput.end());
+				s->signalInput.erase(std::remove(s->signalInput.begin(), s->signalInput.end(), this), s->signalInput.end());
 			}
 
 		public:
+			typedef CombinePolicy combine_policy;
+
 			/** \brief	Default constructor
 			 *
 			 *	\param	initial_value
 			 *		The initial state of the internal bitset.
+			 *	\param	alloc
+			 *		The allocator for the connections.
 			 *	\param	bit_width
 			 *		The size of the internal width of the bitset.
 			 */
-			SynchrotronComponentVector(size_t initial_value = 0) : state(initial_value) {}
+			SynchrotronComponentVector(size_t initial_value = 0, const Allocator& alloc = Allocator())
+				: StatePolicy::template storage<std::bitset<bit_width>>(initial_value), slotOutput(connection_allocator(alloc)), signalInput(connection_allocator(alloc)) {}
+
+			/** \brief	State storage constructor, keeps the state in storage instead of in this SynchrotronComponentVector.
+			 *
+			 *		Only if StatePolicy is ExternalState.
+			 *
+			 *	\param	storage
+			 *		Where to keep the state, must outlive this SynchrotronComponentVector (e.g. a slot of a StateArray).
+			 *	\param	initial_value
+			 *		The initial state of the internal bitset.
+			 *	\param	alloc
+			 *		The allocator for the connections.
+			 */
+			template <class S = StatePolicy, class = typename std::enable_if<S::external>::type>
+			SynchrotronComponentVector(std::bitset<bit_width>& storage, size_t initial_value = 0, const Allocator& alloc = Allocator())
+				: StatePolicy::template storage<std::bitset<bit_width>>(storage, initial_value), slotOutput(connection_allocator(alloc)), signalInput(connection_allocator(alloc)) {}
 
 			/**	\brief
 			 *	Copy constructor
@@ -88,7 +123,7 @@ namespace Synchrotron {
 			 *	\param	duplicateAll_IO
 			 *		Specifies whether to only copy inputs (false) or outputs as well (true).
 			 */
-			SynchrotronComponentVector(const SynchrotronComponentVector& sc, bool duplicateAll_IO = false) : SynchrotronComponentVector() {
+			SynchrotronComponentVector(const SynchrotronComponentVector& sc, bool duplicateAll_IO = false) : SynchrotronComponentVector(0, sc.get_allocator()) {
 				//LockBlock lock(this);
 
 				// Copy subscriptions
@@ -145,6 +180,59 @@ namespace Synchrotron {
 				this->signalInput.clear();
 			}
 
+			/**	\brief	**[Thread safe]** Disconnects all in and outputs, as part of tearing down a whole netlist.
+			 *
+			 *		Only removes this from the connections for which dying(connection) is false.
+			 *		The connections that are destroyed together with this keep their (dangling) pointer to this,
+			 *		which saves erasing every edge from both ends (see Netlist::clear()).
+			 *		Locks this together with every connection that is left, like removeOutput() locks both ends.
+			 *
+			 *	\param	dying
+			 *		Predicate returning whether a connected SynchrotronComponentVector is destroyed together with this one.
+			 */
+			template <class Predicate>
+			void disconnectAll(Predicate dying) {
+				std::vector<SynchrotronComponentVector*> neighbours, current;
+
+				auto snapshot = [&](std::vector<SynchrotronComponentVector*>& into) {
+					into.clear();
+
+					for(auto& connection : this->slotOutput)
+						if (!dying(connection)) into.push_back(connection);
+
+					for(auto& sender : this->signalInput)
+						if (!dying(sender)) into.push_back(sender);
+				};
+
+				{
+					LockBlock lock(this);
+					snapshot(neighbours);
+				}
+
+				// Lock the neighbours as well, and start over if a connection changed before they were all locked
+				for(;; neighbours.swap(current)) {
+					MultiLockBlock lock(this, neighbours.begin(), neighbours.end());
+					snapshot(current);
+
+					if (current != neighbours)
+						continue;
+
+					for(auto& connection : this->slotOutput) {
+						if (!dying(connection))
+							connection->signalInput.erase(std::remove(connection->signalInput.begin(), connection->signalInput.end(), this), connection->signalInput.end());
+					}
+
+					for(auto& sender : this->signalInput) {
+						if (!dying(sender))
+							sender->slotOutput.erase(std::remove(sender->slotOutput.begin(), sender->slotOutput.end(), this), sender->slotOutput.end());
+					}
+
+					this->slotOutput.clear();
+					this->signalInput.clear();
+					return;
+				}
+			}
+
 			/**	\brief	Gets this SynchrotronComponent's bit width.
 			 *
 			 *	\return	size_t
@@ -177,24 +265,64 @@ namespace Synchrotron {
 				return this->state;
 			}
 
+			/**	\brief	Gets this SynchrotronComponent's state by reference, without copying it.
+			 *
+			 *	\return	const std::bitset<bit_width>&
+			 *		Returns the internal bitset, valid as long as this SynchrotronComponent.
+			 */
+			inline const std::bitset<bit_width>& getStateRef() const {
+				return this->state;
+			}
+
+			/**	\brief	Sets this SynchrotronComponentVector's state, without emitting.
+			 *
+			 *	\param	newState
+			 *		The new internal bitset.
+			 */
+			inline void setState(const std::bitset<bit_width>& newState) {
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), this->state, newState);
+				this->state = newState;
+			}
+
 			/**	\brief	Gets the SynchrotronComponent's input connections.
 			 *
-			 *	\return	std::set<SynchrotronComponent*>&
+			 *	\return	const connection_container&
 			 *      Returns a reference set to this SynchrotronComponent's inputs.
 			 */
-			const std::vector<SynchrotronComponentVector*>& getIputs() const {
+			const connection_container& getInputs() const {
 				return this->signalInput;
 			}
 
 			/**	\brief	Gets the SynchrotronComponent's output connections.
 			 *
-			 *	\return	std::set<SynchrotronComponent*>&
+			 *	\return	const connection_container&
 			 *      Returns a reference set to this SynchrotronComponent's outputs.
 			 */
-			const std::vector<SynchrotronComponentVector*>& getOutputs() const {
+			const connection_container& getOutputs() const {
 				return this->slotOutput;
 			}
 
+			/**	\brief	Gets the allocator of the connections.
+			 *
+			 *	\return	Allocator
+			 *		Returns a copy of the allocator this SynchrotronComponentVector was constructed with.
+			 */
+			allocator_type get_allocator() const {
+				return allocator_type(this->slotOutput.get_allocator());
+			}
+
+			/**	\brief	Gets the memory used by this SynchrotronComponentVector: the object itself (with its lock),
+			 *		and the heap nodes and spare capacity of its connections (see SynchrotronMemory.hpp).
+			 *
+			 *		Not synchronized, like getOutputs().
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of bytes.
+			 */
+			size_t memoryUsage() const {
+				return sizeof(*this) + Memory::heapUsage(this->slotOutput) + Memory::heapUsage(this->signalInput);
+			}
+
 			/**	\brief	Adds/Connects a new input to this SynchrotronComponent.
 			 *
 			 *	**Ensures both way connection will be made:**
@@ -204,22 +332,47 @@ namespace Synchrotron {
 			 *		The SynchrotronComponent to connect as input.
 			 */
 			void addInput(SynchrotronComponentVector& input) {
-				LockBlock lock(this);
+				DualLockBlock lock(this, &input);
 
 				// deprecated? //if (!this->hasSameWidth(input)) return false;
 				input.connectSlot(this);
 			}
 
+			/**	\brief	**[Thread safe]** Adds/Connects a range of new inputs to this SynchrotronComponentVector.
+			 *
+			 *	Reserves room for the whole range first. Duplicates within the range are dropped first (keeping the first one),
+			 *	connections that already exist are not searched for, like addInput().
+			 *	This is locked once for every input after it in the lock order, and each input only while it is connected (see forEachLocked()),
+			 *	so the order of the range is kept among the inputs before this in the lock order, and among those after it.
+			 *
+			 *	\param	first, last
+			 *		The range of SynchrotronComponentVector* to connect as input.
+			 */
+			template <class InputIt>
+			void addInput(InputIt first, InputIt last) {
+				std::vector<SynchrotronComponentVector*> inputs(first, last);
+
+				dropDuplicates(inputs);
+
+				{
+					LockBlock lock(this);
+					this->signalInput.reserve(this->signalInput.size() + inputs.size());
+				}
+
+				forEachLocked(this, inputs.begin(), inputs.end(), [this](SynchrotronComponentVector* input) {
+					input->connectSlot(this);
+				});
+			}
+
 			/**	\brief	Adds/Connects a list of new inputs to this SynchrotronComponent.
 			 *
-			 *	Calls addInput() on each SynchrotronComponent* in inputList.
+			 *	Same as addInput(first, last).
 			 *
 			 *	\param	inputList
 			 *		The list of SynchrotronComponents to connect as input.
 			 */
 			void addInput(std::initializer_list<SynchrotronComponentVector*> inputList) {
-				for(auto connection : inputList)
-					this->addInput(*connection);
+				this->addInput(inputList.begin(), inputList.end());
 			}
 
 			/**	\brief	Removes/Disconnects an input to this SynchrotronComponent.
@@ -231,7 +384,7 @@ namespace Synchrotron {
 			 *		The SynchrotronComponent to disconnect as input.
 			 */
 			void removeInput(SynchrotronComponentVector& input) {
-				LockBlock lock(this);
+				DualLockBlock lock(this, &input);
 
 				input.disconnectSlot(this);
 			}
@@ -245,15 +398,40 @@ namespace Synchrotron {
 			 *		The SynchrotronComponent to connect as output.
 			 */
 			void addOutput(SynchrotronComponentVector& output) {
-				LockBlock lock(this);
+				DualLockBlock lock(this, &output);
 
 				// deprecated? //if (!this->hasSameWidth(*output)) return false;
 				this->connectSlot(&output);
 			}
 
+			/**	\brief	**[Thread safe]** Adds/Connects a range of new outputs to this SynchrotronComponentVector.
+			 *
+			 *	Reserves room for the whole range first. Duplicates within the range are dropped first (keeping the first one),
+			 *	connections that already exist are not searched for, like addOutput().
+			 *	This is locked once for every output after it in the lock order, and each output only while it is connected (see forEachLocked()),
+			 *	so the order of the range is kept among the outputs before this in the lock order, and among those after it.
+			 *
+			 *	\param	first, last
+			 *		The range of SynchrotronComponentVector* to connect as output.
+			 */
+			template <class InputIt>
+			void addOutput(InputIt first, InputIt last) {
+				std::vector<SynchrotronComponentVector*> outputs(first, last);
+
+				dropDuplicates(outputs);
+
+				{
+					LockBlock lock(this);
+					this->slotOutput.reserve(this->slotOutput.size() + outputs.size());
+				}
+
+				forEachLocked(this, outputs.begin(), outputs.end(), [this](SynchrotronComponentVector* output) {
+					this->connectSlot(output);
+				});
+			}
+
 			void addOutput(std::initializer_list<SynchrotronComponentVector*> outputList) {
-				for(auto connection : outputList)
-					this->addOutput(*connection);
+				this->addOutput(outputList.begin(), outputList.end());
 			}
 
 			/**	\brief	Removes/Disconnects an output to this SynchrotronComponent.
@@ -265,11 +443,42 @@ namespace Synchrotron {
 			 *		The SynchrotronComponent to disconnect as output.
 			 */
 			void removeOutput(SynchrotronComponentVector& output) {
-				LockBlock lock(this);
+				DualLockBlock lock(this, &output);
 
 				this->disconnectSlot(&output);
 			}
 
+			/**	\brief	Computes the state this SynchrotronComponentVector would get from its inputs, without applying it.
+			 *
+			 *	\return	virtual std::bitset<bit_width>
+			 *		Reduces the inputs with CombinePolicy, a derived class can re-implement this
+			 *		for logic that doesn't fit a policy.
+			 */
+			virtual std::bitset<bit_width> evaluate() const {
+				SYNCHROTRON_STATS_EVALUATE(this->signalInput.size());
+
+				return CombinePolicy::reduce(this->state, this->signalInput.begin(), this->signalInput.end(),
+											 [](const SynchrotronComponentVector* connection) -> const std::bitset<bit_width>& { return connection->getStateRef(); });
+			}
+
+			/**	\brief	Applies evaluate() to this SynchrotronComponentVector's state, without emitting.
+			 *
+			 *	Used by tick() and by the iterative Scheduler to propagate without recursion.
+			 *
+			 *	\return	bool
+			 *		Returns whether the state has changed.
+			 */
+			bool update() {
+				std::bitset<bit_width> prevState = this->state;
+
+				this->state = this->evaluate();
+
+				SYNCHROTRON_STATS_TICK(prevState != this->state);
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), prevState, this->state);
+
+				return prevState != this->state;
+			}
+
 			/**	\brief	The tick() method will be called when one of this SynchrotronComponent's inputs issues an emit().
 			 *
 			 *	\return	virtual void
@@ -277,31 +486,64 @@ namespace Synchrotron {
 			 */
 			virtual void tick() {
 				//LockBlock lock(this);
-				std::bitset<bit_width> prevState = this->state;
 
 				//std::cout << "Ticked\n";
-				for(auto& connection : this->signalInput) {
-					// Change this line to change the logic applied on the states:
-					this->state |= ((SynchrotronComponentVector*) connection)->getState();
-				}
+				// Directly emit changes to subscribers on change
+				if (this->update())
+					this->emit();
+			}
+
+			/**	\brief	The tick(source) method will be called when source, one of this SynchrotronComponentVector's inputs, issues an emit().
+			 *
+			 *	\param	source
+			 *		The input that emitted.
+			 *
+			 *	\return	virtual void
+			 *		Calls tick(), so a derived class re-implementing tick() or evaluate() keeps working.
+			 *		Incremental<SynchrotronComponentVector> re-implements it to merge only source (see SynchrotronCombine.hpp).
+			 */
+			virtual void tick(SynchrotronComponentVector& source) {
+				(void) source;
+				this->tick();
+			}
+
+		protected:
+			/**	\brief	Merges only the state of source and emits on change, at O(1) instead of O(fan-in) per input event.
+			 *
+			 *	Only gives the same state as tick() if CombinePolicy is incremental (e.g. OR, which is monotone)
+			 *	and the state already holds every other input, i.e. it was tick()ed since they were connected.
+			 *
+			 *	\param	source
+			 *		The input that emitted.
+			 */
+			void tickMerge(const SynchrotronComponentVector& source) {
+				//LockBlock lock(this);
+				std::bitset<bit_width> prevState = this->state;
+
+				CombinePolicy::merge(this->state, source.getStateRef());
+				SYNCHROTRON_STATS_TICK(prevState != this->state);
+				SYNCHROTRON_TRACE_CHANGE(this->getId(), prevState, this->state);
 
 				// Directly emit changes to subscribers on change
 				if (prevState != this->state)
 					this->emit();
 			}
 
+		public:
+
 			/**	\brief	The emit() method will be called after a tick() completes to ensure the flow of new data.
 			 *
-			 *	Loops over all outputs and calls tick().
+			 *	Loops over all outputs and calls tick(*this).
 			 *
 			 *	\return	virtual void
 			 *		This method can be re-implemented by a derived class.
 			 */
 			virtual inline void emit() {
 				//LockBlock lock(this);
+				SYNCHROTRON_STATS_EMIT(this->slotOutput.size());
 
 				for(auto& connection : this->slotOutput) {
-					connection->tick();
+					connection->tick(*this);
 				}
 				//std::cout << "Emitted\n";
 			}
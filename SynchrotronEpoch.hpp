@@ -0,0 +1,242 @@
+#ifndef SYNCHROTRONEPOCH_HPP
+#define SYNCHROTRONEPOCH_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	EpochManager implements epoch based reclamation: memory that readers may still be traversing
+	 *	is retired instead of deleted, and only freed once every reader that could have seen it has left.
+	 *
+	 *	*	Readers enter with an EpochGuard, which publishes the global epoch in a per-thread record.
+	 *		This is a store and a fence, without taking a lock or writing to a shared cache line.
+	 *	*	Writers unlink the old version, then retire() it with the current epoch.
+	 *	*	collect() frees what was retired before the oldest epoch a reader is still in, and advances the epoch.
+	 *		synchronize() waits for the grace period: until every reader that entered before it has left.
+	 *
+	 *	There is one instance, shared by every thread (see instance()).
+	 */
+	class EpochManager {
+		public:
+			static const size_t MAX_THREADS = 256;
+
+		private:
+			static const size_t INACTIVE = 0;
+
+			/**	\brief
+			 *	retire() calls collect() once this many pointers are waiting, so writers don't have to.
+			 */
+			static const size_t COLLECT_THRESHOLD = 1024;
+
+			/**	\brief
+			 *	The epoch a thread is reading in (INACTIVE outside a guard), on its own cache line.
+			 */
+			struct alignas(64) Record {
+				std::atomic<size_t>	epoch;
+				std::atomic<bool>	claimed;
+			};
+
+			struct Retired {
+				void*	pointer;
+				void	(*deleter)(void*);
+				size_t	epoch;
+			};
+
+			/**	\brief
+			 *	Claims a Record for the current thread, and releases it when the thread exits.
+			 */
+			struct ThreadSlot {
+				Record*	record;
+				size_t	nesting;
+
+				ThreadSlot() : record(nullptr), nesting(0) {
+					for(auto& r : EpochManager::instance().records) {
+						bool expected = false;
+						if (r.claimed.compare_exchange_strong(expected, true)) {
+							this->record = &r;
+							return;
+						}
+					}
+
+					throw std::runtime_error("EpochManager: more than MAX_THREADS reading threads");
+				}
+
+				~ThreadSlot() {
+					this->record->epoch.store(INACTIVE, std::memory_order_release);
+					this->record->claimed.store(false, std::memory_order_release);
+				}
+			};
+
+			Record					records[MAX_THREADS];
+			std::atomic<size_t>		m_epoch;
+
+			std::mutex				m_mutex;
+			std::vector<Retired>	m_retired;
+
+			EpochManager() : m_epoch(1) {
+				for(auto& r : this->records) {
+					r.epoch.store(INACTIVE);
+					r.claimed.store(false);
+				}
+			}
+
+			static inline ThreadSlot& slot() {
+				static thread_local ThreadSlot s;
+				return s;
+			}
+
+			/**	\brief	Gets the oldest epoch a reader is in, or the current epoch if there are none.
+			 */
+			size_t oldestEpoch() const {
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+
+				size_t oldest = this->m_epoch.load();
+
+				for(auto& r : this->records) {
+					const size_t e = r.epoch.load(std::memory_order_acquire);
+					if (e != INACTIVE && e < oldest) oldest = e;
+				}
+
+				return oldest;
+			}
+
+		public:
+			EpochManager(const EpochManager&) = delete;
+			EpochManager& operator=(const EpochManager&) = delete;
+
+			~EpochManager() {
+				for(auto& r : this->m_retired) r.deleter(r.pointer);
+			}
+
+			/**	\brief	Gets the EpochManager shared by all threads.
+			 */
+			static EpochManager& instance() {
+				static EpochManager manager;
+				return manager;
+			}
+
+			/**	\brief	Gets the current global epoch.
+			 */
+			inline size_t getEpoch() const {
+				return this->m_epoch.load();
+			}
+
+			/**	\brief	Gets the amount of retired pointers that haven't been freed yet.
+			 */
+			size_t getRetiredCount() {
+				std::lock_guard<std::mutex> lock(this->m_mutex);
+				return this->m_retired.size();
+			}
+
+			/**	\brief	Enters a read-side critical section on this thread, nested sections are allowed.
+			 */
+			inline void enter() {
+				ThreadSlot& s = slot();
+
+				if (s.nesting++ == 0) {
+					s.record->epoch.store(this->m_epoch.load(), std::memory_order_seq_cst);
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+				}
+			}
+
+			/**	\brief	Leaves the read-side critical section entered by enter().
+			 */
+			inline void leave() {
+				ThreadSlot& s = slot();
+
+				if (--s.nesting == 0)
+					s.record->epoch.store(INACTIVE, std::memory_order_release);
+			}
+
+			/**	\brief	Retires pointer: deleter(pointer) is called once no reader can be traversing it anymore.
+			 *
+			 *	\param	pointer
+			 *		The memory that has been unlinked, so new readers can't reach it.
+			 *	\param	deleter
+			 *		Frees pointer.
+			 */
+			void retire(void* pointer, void (*deleter)(void*)) {
+				Retired r;
+				r.pointer = pointer;
+				r.deleter = deleter;
+				r.epoch   = this->m_epoch.load();
+
+				size_t waiting;
+
+				{
+					std::lock_guard<std::mutex> lock(this->m_mutex);
+					this->m_retired.push_back(r);
+					waiting = this->m_retired.size();
+				}
+
+				if (waiting % COLLECT_THRESHOLD == 0)
+					this->collect();
+			}
+
+			/**	\brief	Frees everything retired before the oldest reader entered, without waiting, and advances the epoch.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of freed pointers.
+			 */
+			size_t collect() {
+				std::vector<Retired> freeable;
+
+				{
+					std::lock_guard<std::mutex> lock(this->m_mutex);
+
+					const size_t oldest = this->oldestEpoch();
+					size_t kept = 0;
+
+					for(auto& r : this->m_retired) {
+						if (r.epoch < oldest)
+							freeable.push_back(r);
+						else
+							this->m_retired[kept++] = r;
+					}
+
+					this->m_retired.resize(kept);
+					this->m_epoch.fetch_add(1);
+				}
+
+				for(auto& r : freeable) r.deleter(r.pointer);
+
+				return freeable.size();
+			}
+
+			/**	\brief	Waits for a grace period, then frees everything retired before this call.
+			 *
+			 *		Must not be called from inside a read-side critical section, since it would wait for itself.
+			 */
+			void synchronize() {
+				const size_t target = this->m_epoch.fetch_add(1) + 1;
+
+				while (this->oldestEpoch() < target)
+					std::this_thread::yield();
+
+				this->collect();
+			}
+	};
+
+	/**	\brief
+	 *	Creating a new EpochGuard enters a read-side critical section,
+	 *	while leaving the scope conveniently leaves it.
+	 *
+	 *		Everything reached through an RcuSet stays valid while the guard lives.
+	 */
+	class EpochGuard {
+		public:
+			EpochGuard()					{ EpochManager::instance().enter();	}
+			~EpochGuard()					{ EpochManager::instance().leave();	}
+
+			EpochGuard(const EpochGuard&) = delete;
+			EpochGuard& operator=(const EpochGuard&) = delete;
+	};
+}
+
+#endif // SYNCHROTRONEPOCH_HPP
@@ -0,0 +1,356 @@
+#ifndef SYNCHROTRONFLATHASHSET_HPP
+#define SYNCHROTRONFLATHASHSET_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	Hashes a pointer with Fibonacci hashing, since std::hash<T*> is usually the identity,
+	 *	which clusters badly in an open-addressing table (heap pointers share their low bits).
+	 */
+	struct PointerHash {
+		template <class T>
+		inline size_t operator() (const T* p) const {
+			return size_t((uint64_t(reinterpret_cast<uintptr_t>(p)) >> 3) * 0x9E3779B97F4A7C15ull >> 16);
+		}
+	};
+
+	/** \brief
+	 *	FlatHashSet is a set without duplicates, that keeps its elements in a dense array in insertion order
+	 *	and finds them through an open-addressing (linear probing) index.
+	 *
+	 *	*	insert() appends to the dense array: O(1) average.
+	 *	*	erase() leaves a hole in the dense array: O(1) average. Once more than half of the array is holes,
+	 *		it is compacted (keeping the order) and the index rebuilt for the elements that are left,
+	 *		which is O(1) amortized. Erasing the last element releases both.
+	 *	*	Iterating walks the dense array, skipping holes.
+	 *
+	 *	T() marks a hole, so it can't be inserted (e.g. nullptr for pointers).
+	 *
+	 *	\param	T
+	 *		The element type, should be cheap to copy (e.g. a pointer).
+	 *	\param	Hash
+	 *		The hash function for T.
+	 *	\param	Allocator
+	 *		The allocator of the dense array and the index.
+	 */
+	template <class T, class Hash = PointerHash, class Allocator = std::allocator<T>>
+	class FlatHashSet {
+		private:
+			static const size_t EMPTY     = size_t(-1);
+			static const size_t TOMBSTONE = size_t(-2);
+			static const size_t MIN_SLOTS = 8;
+
+			/**	\brief
+			 *	An index slot: the element and its position in the dense array.
+			 */
+			struct Slot {
+				T		key;
+				size_t	pos;
+			};
+
+			/**	\brief
+			 *	The elements in insertion order, T() for erased elements.
+			 */
+			std::vector<T, Allocator> m_dense;
+
+			/**	\brief
+			 *	Open-addressing index into m_dense, its size is a power of 2.
+			 */
+			std::vector<Slot, typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>> m_slots;
+
+			size_t	m_holes;
+			size_t	m_used;
+			Hash	m_hash;
+
+			inline size_t mask() const {
+				return this->m_slots.size() - 1;
+			}
+
+			/**	\brief	Gets the amount of slots to index count elements with, keeping the load under 3/8.
+			 */
+			static inline size_t slotsFor(size_t count) {
+				size_t slots = MIN_SLOTS;
+				while (slots * 3 <= count * 4 * 2) slots *= 2;
+				return slots;
+			}
+
+			/**	\brief	Finds the slot of value.
+			 *
+			 *	\return	size_t
+			 *		Returns the slot holding value, or EMPTY.
+			 */
+			size_t find(const T& value) const {
+				if (this->m_slots.empty())
+					return EMPTY;
+
+				for(size_t i = this->m_hash(value) & this->mask();; i = (i + 1) & this->mask()) {
+					const Slot& slot = this->m_slots[i];
+
+					if (slot.pos == EMPTY)
+						return EMPTY;
+
+					if (slot.pos != TOMBSTONE && slot.key == value)
+						return i;
+				}
+			}
+
+			/**	\brief	Puts value at dense position pos in the index, value should not be in it.
+			 */
+			void place(const T& value, size_t pos) {
+				size_t i = this->m_hash(value) & this->mask();
+
+				while (this->m_slots[i].pos != EMPTY && this->m_slots[i].pos != TOMBSTONE)
+					i = (i + 1) & this->mask();
+
+				if (this->m_slots[i].pos == EMPTY)
+					++this->m_used;
+
+				this->m_slots[i].key = value;
+				this->m_slots[i].pos = pos;
+			}
+
+			/**	\brief	Removes the holes from the dense array and rebuilds the index with room for slots,
+			 *		giving back the memory of both if they shrink.
+			 */
+			void rebuild(size_t slots) {
+				if (this->m_holes) {
+					size_t j = 0;
+
+					for(size_t i = 0; i < this->m_dense.size(); i++) {
+						if (this->m_dense[i] != T())
+							this->m_dense[j++] = this->m_dense[i];
+					}
+
+					this->m_dense.resize(j);
+					this->m_holes = 0;
+
+					if (this->m_dense.capacity() > 4 * j)
+						this->m_dense.shrink_to_fit();
+				}
+
+				Slot empty;
+				empty.key = T();
+				empty.pos = EMPTY;
+
+				if (slots < this->m_slots.size())
+					decltype(this->m_slots)(slots, empty, this->m_slots.get_allocator()).swap(this->m_slots);
+				else
+					this->m_slots.assign(slots, empty);
+				this->m_used = 0;
+
+				for(size_t i = 0; i < this->m_dense.size(); i++)
+					this->place(this->m_dense[i], i);
+			}
+
+		public:
+			/** \brief
+			 *	Bidirectional iterator over the dense array, skipping holes.
+			 */
+			class const_iterator {
+				private:
+					const T* m_pos;
+					const T* m_end;
+
+					inline void skip() {
+						while (this->m_pos != this->m_end && *this->m_pos == T())
+							++this->m_pos;
+					}
+
+				public:
+					typedef std::bidirectional_iterator_tag	iterator_category;
+					typedef T								value_type;
+					typedef std::ptrdiff_t					difference_type;
+					typedef const T*						pointer;
+					typedef const T&						reference;
+
+					const_iterator() : m_pos(nullptr), m_end(nullptr) {}
+					const_iterator(const T* pos, const T* end) : m_pos(pos), m_end(end) { this->skip(); }
+
+					inline reference operator*() const			{ return *this->m_pos;	}
+					inline pointer operator->() const			{ return this->m_pos;	}
+
+					inline const_iterator& operator++()			{ ++this->m_pos; this->skip(); return *this;	}
+					inline const_iterator operator++(int)		{ const_iterator it(*this); ++*this; return it;	}
+
+					// Like any bidirectional iterator, only valid if there is an element in front
+					inline const_iterator& operator--()			{ do { --this->m_pos; } while (*this->m_pos == T()); return *this;	}
+					inline const_iterator operator--(int)		{ const_iterator it(*this); --*this; return it;	}
+
+					inline bool operator==(const const_iterator& other) const	{ return this->m_pos == other.m_pos;	}
+					inline bool operator!=(const const_iterator& other) const	{ return this->m_pos != other.m_pos;	}
+			};
+
+			typedef T										value_type;
+			typedef size_t									size_type;
+			typedef const_iterator							iterator;
+			typedef std::reverse_iterator<const_iterator>	const_reverse_iterator;
+			typedef const_reverse_iterator					reverse_iterator;
+			typedef Allocator								allocator_type;
+
+			FlatHashSet() : m_holes(0), m_used(0) {}
+			explicit FlatHashSet(const Allocator& alloc) : m_dense(alloc), m_slots(alloc), m_holes(0), m_used(0) {}
+
+			inline allocator_type get_allocator() const		{ return this->m_dense.get_allocator();				}
+
+			inline const_iterator begin() const				{ return const_iterator(this->m_dense.data(), this->m_dense.data() + this->m_dense.size());	}
+			inline const_iterator end() const				{ return const_iterator(this->m_dense.data() + this->m_dense.size(), this->m_dense.data() + this->m_dense.size());	}
+			inline const_iterator cbegin() const			{ return this->begin();								}
+			inline const_iterator cend() const				{ return this->end();								}
+			inline const_reverse_iterator rbegin() const	{ return const_reverse_iterator(this->end());		}
+			inline const_reverse_iterator rend() const		{ return const_reverse_iterator(this->begin());		}
+			inline const_reverse_iterator crbegin() const	{ return this->rbegin();							}
+			inline const_reverse_iterator crend() const		{ return this->rend();								}
+
+			inline size_t size() const						{ return this->m_dense.size() - this->m_holes;		}
+			inline bool empty() const						{ return this->size() == 0;							}
+
+			/**	\brief	Gets the bytes allocated for the dense array and the index, including their spare capacity.
+			 */
+			inline size_t heapUsage() const {
+				return this->m_dense.capacity() * sizeof(T) + this->m_slots.capacity() * sizeof(Slot);
+			}
+
+			/**	\brief	Makes room for at least count elements, so they can be inserted without rebuilding the index.
+			 */
+			void reserve(size_t count) {
+				this->m_dense.reserve(count + this->m_holes);
+
+				size_t slots = MIN_SLOTS;
+				while (slots * 3 <= count * 4) slots *= 2;
+
+				if (slots > this->m_slots.size())
+					this->rebuild(slots);
+			}
+
+			/**	\brief	Appends value, unless it is already in the set.
+			 *
+			 *	\return	bool
+			 *		Returns whether value was inserted.
+			 */
+			bool insert(const T& value) {
+				assert(value != T());
+
+				if (this->find(value) != EMPTY)
+					return false;
+
+				// Keep the load (including tombstones) under 3/4
+				if ((this->m_used + 1) * 4 > this->m_slots.size() * 3)
+					this->rebuild(slotsFor(this->size() + 1));
+
+				this->m_dense.push_back(value);
+				this->place(value, this->m_dense.size() - 1);
+
+				return true;
+			}
+
+			/**	\brief	Same as insert(value), the hint is ignored (for compatibility with std::set).
+			 */
+			inline void insert(const_iterator, const T& value) {
+				this->insert(value);
+			}
+
+			/**	\brief	Erases value, if it is in the set.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of elements erased (0 or 1).
+			 */
+			size_t erase(const T& value) {
+				const size_t i = this->find(value);
+
+				if (i == EMPTY)
+					return 0;
+
+				this->m_dense[this->m_slots[i].pos] = T();
+				this->m_slots[i].key = T();
+				this->m_slots[i].pos = TOMBSTONE;
+				++this->m_holes;
+
+				if (this->m_holes == this->m_dense.size()) {
+					// Not clear(), which would reset every slot of a table that may once have held far more
+					decltype(this->m_dense)(this->m_dense.get_allocator()).swap(this->m_dense);
+					decltype(this->m_slots)(this->m_slots.get_allocator()).swap(this->m_slots);
+					this->m_holes = 0;
+					this->m_used  = 0;
+				} else if (this->m_holes > this->m_dense.size() / 2) {
+					this->rebuild(std::min(this->m_slots.size(), slotsFor(this->size())));
+				}
+
+				return 1;
+			}
+
+			/**	\brief	Whether value is in the set.
+			 *
+			 *	\return	size_t
+			 *		Returns 1 if value is in the set, 0 otherwise.
+			 */
+			inline size_t count(const T& value) const {
+				return this->find(value) != EMPTY ? 1 : 0;
+			}
+
+			/**	\brief	Removes every element, keeping the capacity.
+			 */
+			void clear() {
+				this->m_dense.clear();
+				this->m_holes = 0;
+
+				Slot empty;
+				empty.key = T();
+				empty.pos = EMPTY;
+
+				this->m_slots.assign(this->m_slots.size(), empty);
+				this->m_used = 0;
+			}
+	};
+
+	/**	\brief	Drops every pointer that already came earlier in values, keeping the order of the rest, in O(n).
+	 *
+	 *	\param	values
+	 *		The pointers, none of them nullptr.
+	 */
+	template <class T>
+	void dropDuplicates(std::vector<T*>& values) {
+		size_t kept = 0;
+
+		if (values.size() <= 8) {
+			// Cheaper than hashing for a handful of pointers
+			for(size_t i = 0; i < values.size(); i++) {
+				if (std::find(values.begin(), values.begin() + kept, values[i]) == values.begin() + kept)
+					values[kept++] = values[i];
+			}
+		} else {
+			// A bare open-addressing table at a load under 1/2, no dense array nor tombstones needed
+			size_t slots = 16;
+			while (slots < 2 * values.size()) slots *= 2;
+
+			std::vector<T*> seen(slots, nullptr);
+			const size_t mask = slots - 1;
+			PointerHash hash;
+
+			for(size_t i = 0; i < values.size(); i++) {
+				size_t slot = hash(values[i]) & mask;
+
+				while (seen[slot] != nullptr && seen[slot] != values[i])
+					slot = (slot + 1) & mask;
+
+				if (seen[slot] == nullptr) {
+					seen[slot] = values[i];
+					values[kept++] = values[i];
+				}
+			}
+		}
+
+		values.resize(kept);
+	}
+}
+
+#endif // SYNCHROTRONFLATHASHSET_HPP
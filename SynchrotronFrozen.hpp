@@ -0,0 +1,291 @@
+#ifndef SYNCHROTRONFROZEN_HPP
+#define SYNCHROTRONFROZEN_HPP
+
+#include "SynchrotronGraph.hpp"
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	FrozenNetlist is a frozen-topology copy of a connected graph of Components,
+	 *	stored in compressed sparse row (CSR) form.
+	 *
+	 *	All fan-in and fan-out of the graph is kept in two offset+index array pairs,
+	 *	costing sizeof(Index) (4) bytes per edge per direction instead of a tree node per edge per direction,
+	 *	and the states of all Components are kept in one contiguous array.
+	 *	tick() and emit() offer the same semantics as on the Components,
+	 *	but work on indices into these arrays and propagate iteratively.
+	 *
+	 *	Like CompiledNetlist, this applies the combine_policy of Component.
+	 *	Changing the topology of the live graph requires another freeze().
+	 *
+	 *	\param	Component
+	 *		The SynchrotronComponent type of the graph.
+	 *	\param	Index
+	 *		The unsigned type of the offsets and indices, it bounds the amount of Components and of edges per direction
+	 *		(freeze() throws std::length_error beyond it). uint64_t for graphs of 2^32 edges or more, at twice the memory.
+	 */
+	template <class Component, class Index = uint32_t>
+	class FrozenNetlist {
+		public:
+			typedef typename std::decay<decltype(std::declval<const Component&>().getState())>::type state_type;
+			typedef typename Component::combine_policy combine_policy;
+			typedef Index index_type;
+
+			static_assert(std::is_unsigned<Index>::value, "FrozenNetlist needs an unsigned Index");
+
+		private:
+			/**	\brief
+			 *	Every Component in the graph, in breadth first order.
+			 */
+			std::vector<Component*> components;
+
+			/**	\brief
+			 *	The state of every Component, same order as components.
+			 */
+			std::vector<state_type> states;
+
+			/**	\brief
+			 *	**Signals == inputs**
+			 *
+			 *		The inputs of i are in inputIndices[inputOffsets[i] .. inputOffsets[i+1]].
+			 */
+			std::vector<index_type> inputOffsets, inputIndices;
+
+			/**	\brief
+			 *	**Slots == outputs**
+			 *
+			 *		The outputs of i are in outputIndices[outputOffsets[i] .. outputOffsets[i+1]].
+			 */
+			std::vector<index_type> outputOffsets, outputIndices;
+
+			/**	\brief
+			 *	Worklist and its pending flags, kept to reuse their capacity between calls.
+			 */
+			std::vector<index_type> worklist;
+			std::vector<bool> pending;
+
+			/**	\brief	Appends i to the worklist, if it wasn't pending already.
+			 */
+			inline void schedule(index_type i) {
+				if (!this->pending[i]) {
+					this->pending[i] = true;
+					this->worklist.push_back(i);
+				}
+			}
+
+			/**	\brief	Updates the worklist in FIFO order until every change has been propagated.
+			 */
+			void run() {
+				for(size_t head = 0; head < this->worklist.size(); head++) {
+					const index_type i = this->worklist[head];
+					this->pending[i] = false;
+
+					if (this->update(i))
+						this->emitOutputs(i);
+				}
+
+				this->worklist.clear();
+			}
+
+			/**	\brief	Schedules every output of i.
+			 */
+			inline void emitOutputs(index_type i) {
+				for(index_type j = this->outputOffsets[i]; j < this->outputOffsets[i + 1]; j++)
+					this->schedule(this->outputIndices[j]);
+			}
+
+			/**	\brief	Drops the graph, after a freeze() that didn't fit in index_type.
+			 */
+			void reset() {
+				this->components.clear();
+				this->states.clear();
+				this->inputOffsets.assign(1, 0);
+				this->outputOffsets.assign(1, 0);
+				this->inputIndices.clear();
+				this->outputIndices.clear();
+				this->pending.clear();
+			}
+
+		public:
+			/** \brief	Default constructor, freeze() still has to be called.
+			 */
+			FrozenNetlist() {}
+
+			/** \brief	Freezes the graph connected to the Components in list.
+			 *
+			 *	\param	list
+			 *		Any of the Components in the graph(s) to freeze.
+			 */
+			FrozenNetlist(std::initializer_list<Component*> list) {
+				this->freeze(list.begin(), list.end());
+			}
+
+			/**	\brief	(Re)builds the CSR arrays for the graph connected to [first, last).
+			 *
+			 *	\param	first, last
+			 *		A range of Component* from the graph(s) to freeze.
+			 *
+			 *	\throws	std::length_error
+			 *		If the amount of Components or of edges doesn't fit in index_type, leaving an empty graph.
+			 */
+			template <class InputIt>
+			void freeze(InputIt first, InputIt last) {
+				const size_t max = std::numeric_limits<index_type>::max();
+
+				this->components = collectComponents<Component>(first, last);
+
+				// indexOf() returns size() for a Component that isn't part of the graph
+				if (this->components.size() > max) {
+					this->reset();
+					throw std::length_error("FrozenNetlist: more Components than index_type can address");
+				}
+
+				const auto index = indexComponents(this->components);
+
+				this->inputOffsets.assign(1, 0);
+				this->outputOffsets.assign(1, 0);
+				this->inputIndices.clear();
+				this->outputIndices.clear();
+
+				for(auto& c : this->components) {
+					for(auto& sender : c->getInputs())
+						this->inputIndices.push_back(index_type(index.at(sender)));
+
+					for(auto& connection : c->getOutputs())
+						this->outputIndices.push_back(index_type(index.at(connection)));
+
+					// The offsets would wrap around
+					if (this->inputIndices.size() > max || this->outputIndices.size() > max) {
+						this->reset();
+						throw std::length_error("FrozenNetlist: more edges than index_type can address");
+					}
+
+					this->inputOffsets.push_back(index_type(this->inputIndices.size()));
+					this->outputOffsets.push_back(index_type(this->outputIndices.size()));
+				}
+
+				this->inputIndices.shrink_to_fit();
+				this->outputIndices.shrink_to_fit();
+
+				this->states.resize(this->components.size());
+				this->pending.assign(this->components.size(), false);
+				this->load();
+			}
+
+			/**	\brief	Gets the amount of Components in the graph.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of nodes.
+			 */
+			size_t size() const {
+				return this->components.size();
+			}
+
+			/**	\brief	Gets the amount of connections in the graph.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of edges.
+			 */
+			size_t getEdgeCount() const {
+				return this->outputIndices.size();
+			}
+
+			/**	\brief	Gets the Components in the graph, in index order.
+			 *
+			 *	\return	std::vector<Component*>&
+			 *		Returns a reference to every Component.
+			 */
+			const std::vector<Component*>& getComponents() const {
+				return this->components;
+			}
+
+			/**	\brief	Looks up the index of a Component, in O(n).
+			 *
+			 *	\param	c
+			 *		The Component to find, it should be part of the frozen graph.
+			 *
+			 *	\return	index_type
+			 *		Returns the index of c, or size() if it isn't part of the graph.
+			 */
+			index_type indexOf(const Component& c) const {
+				for(size_t i = 0; i < this->components.size(); i++) {
+					if (this->components[i] == &c)
+						return index_type(i);
+				}
+
+				return index_type(this->components.size());
+			}
+
+			/**	\brief	Gets the state of the Component at i.
+			 *
+			 *	\return	state_type&
+			 *		Returns a reference to the state in the array.
+			 */
+			inline const state_type& getState(index_type i) const {
+				return this->states[i];
+			}
+
+			/**	\brief	Sets the state of the Component at i, without emitting.
+			 */
+			inline void setState(index_type i, const state_type& newState) {
+				this->states[i] = newState;
+			}
+
+			/**	\brief	Copies the state of every Component into the array.
+			 */
+			void load() {
+				for(size_t i = 0; i < this->components.size(); i++)
+					this->states[i] = this->components[i]->getState();
+			}
+
+			/**	\brief	Copies the array back into the state of every Component.
+			 */
+			void store() {
+				for(size_t i = 0; i < this->components.size(); i++)
+					this->components[i]->setState(this->states[i]);
+			}
+
+			/**	\brief	Applies the inputs of i to its state, without emitting.
+			 *
+			 *	\return	bool
+			 *		Returns whether the state has changed.
+			 */
+			bool update(index_type i) {
+				const index_type* indices = this->inputIndices.data();
+
+				// Same logic as SynchrotronComponent::evaluate()
+				const state_type nextState = combine_policy::reduce(this->states[i],
+																	indices + this->inputOffsets[i],
+																	indices + this->inputOffsets[i + 1],
+																	[this](index_type j) -> const state_type& { return this->states[j]; });
+
+				const bool changed = nextState != this->states[i];
+				this->states[i] = nextState;
+
+				return changed;
+			}
+
+			/**	\brief	Same as SynchrotronComponent::tick() for the Component at i.
+			 */
+			void tick(index_type i) {
+				this->schedule(i);
+				this->run();
+			}
+
+			/**	\brief	Same as SynchrotronComponent::emit() for the Component at i.
+			 */
+			void emit(index_type i) {
+				this->emitOutputs(i);
+				this->run();
+			}
+	};
+}
+
+#endif // SYNCHROTRONFROZEN_HPP
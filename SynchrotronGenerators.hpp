@@ -0,0 +1,206 @@
+#ifndef SYNCHROTRONGENERATORS_HPP
+#define SYNCHROTRONGENERATORS_HPP
+
+#include "SynchrotronNetlist.hpp"
+#include "SynchrotronTopology.hpp"
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	Generators build parametric graphs of Components in a Netlist, as workloads for benchmarks and checks.
+	 *
+	 *	Every generator creates its Components in the given Netlist, connects them with a single TopologyBuilder::commit(),
+	 *	and returns the new Components in order of creation. The first one gets initial_value as its state, the others 0,
+	 *	so emit()ting the first one propagates through the whole graph.
+	 *
+	 *	Every graph but the ring is acyclic, with connections only from earlier to later Components.
+	 */
+	namespace Generators {
+
+		/**	\brief	Creates count Components in netlist, the first with initial_value.
+		 */
+		template <class Component>
+		std::vector<Component*> createComponents(Netlist<Component>& netlist, size_t count, size_t initial_value) {
+			std::vector<Component*> components;
+			components.reserve(count);
+
+			for(size_t i = 0; i < count; i++)
+				components.push_back(&netlist.create(i == 0 ? initial_value : 0));
+
+			return components;
+		}
+
+		/**	\brief	Builds a chain: every Component outputs to the next one.
+		 *
+		 *	\param	length
+		 *		The amount of Components, a propagation is length - 1 deep.
+		 *
+		 *	\return	std::vector<Component*>
+		 *		Returns the Components, front() is the start of the chain, back() the end.
+		 */
+		template <class Component>
+		std::vector<Component*> chain(Netlist<Component>& netlist, size_t length, size_t initial_value = 1) {
+			std::vector<Component*>		components = createComponents(netlist, length, initial_value);
+			TopologyBuilder<Component>	builder;
+
+			builder.reserve(length);
+
+			for(size_t i = 1; i < length; i++)
+				builder.connect(*components[i - 1], *components[i]);
+
+			builder.commit();
+
+			return components;
+		}
+
+		/**	\brief	Builds a balanced tree: every Component above the leaves outputs to fan_out children.
+		 *
+		 *	\param	fan_out
+		 *		The amount of children of every inner Component, at least 1.
+		 *	\param	depth
+		 *		The amount of levels below the root, 0 is the root alone.
+		 *
+		 *	\return	std::vector<Component*>
+		 *		Returns the Components in breadth first order, front() is the root,
+		 *		the children of Component i are i * fan_out + 1 to i * fan_out + fan_out.
+		 */
+		template <class Component>
+		std::vector<Component*> tree(Netlist<Component>& netlist, size_t fan_out, size_t depth, size_t initial_value = 1) {
+			size_t count = 1, level = 1;
+
+			for(size_t d = 0; d < depth; d++) {
+				level *= fan_out;
+				count += level;
+			}
+
+			std::vector<Component*>		components = createComponents(netlist, count, initial_value);
+			TopologyBuilder<Component>	builder;
+
+			builder.reserve(count);
+
+			for(size_t i = 1; i < count; i++)
+				builder.connect(*components[(i - 1) / fan_out], *components[i]);
+
+			builder.commit();
+
+			return components;
+		}
+
+		/**	\brief	Builds an Erdős–Rényi random DAG: every pair i < j is connected from i to j with the given probability.
+		 *
+		 *		The pairs that get a connection are drawn with geometric skips (Batagelj and Brandes),
+		 *		so building takes O(nodes + connections) instead of O(nodes²).
+		 *
+		 *	\param	nodes
+		 *		The amount of Components.
+		 *	\param	probability
+		 *		The chance of every connection, the average fan-in of Component j is probability * j.
+		 *	\param	random
+		 *		The random number generator, seed it for a reproducible graph.
+		 *
+		 *	\return	std::vector<Component*>
+		 *		Returns the Components in topological order.
+		 */
+		template <class Component, class Random>
+		std::vector<Component*> randomDag(Netlist<Component>& netlist, size_t nodes, double probability, Random& random, size_t initial_value = 1) {
+			std::vector<Component*>		components = createComponents(netlist, nodes, initial_value);
+			TopologyBuilder<Component>	builder;
+
+			if (probability >= 1) {
+				for(size_t j = 1; j < nodes; j++)
+					builder.fanIn(components.begin(), components.begin() + j, *components[j]);
+			} else if (probability > 0) {
+				std::uniform_real_distribution<double> uniform(0, 1);
+				const double logq = std::log(1 - probability);
+
+				builder.reserve(size_t(probability * nodes * (nodes - 1) / 2));
+
+				// Walk the pairs (i, j), i < j, row by row, skipping a geometric amount of pairs between two connections
+				size_t j = 1;
+				double i = -1;
+
+				while (j < nodes) {
+					i += 1 + std::floor(std::log(1 - uniform(random)) / logq);
+
+					while (i >= j && j < nodes) {
+						i -= j;
+						++j;
+					}
+
+					if (j < nodes)
+						builder.connect(*components[size_t(i)], *components[j]);
+				}
+			}
+
+			builder.commit();
+
+			return components;
+		}
+
+		/**	\brief	Builds a ring: a chain whose last Component outputs back to the first one.
+		 *
+		 *		Clocked with a ClockedNetlist, the state of every Component moves one place along the ring per step.
+		 *		With a policy that only passes its single input on (e.g. XorPolicy) that is a ring counter,
+		 *		with OrPolicy the ring fills up in length - 1 steps.
+		 *		emit() on a ring stops once a state comes back unchanged.
+		 *
+		 *	\param	length
+		 *		The amount of Components.
+		 *
+		 *	\return	std::vector<Component*>
+		 *		Returns the Components in order along the ring.
+		 */
+		template <class Component>
+		std::vector<Component*> ring(Netlist<Component>& netlist, size_t length, size_t initial_value = 1) {
+			std::vector<Component*>		components = createComponents(netlist, length, initial_value);
+			TopologyBuilder<Component>	builder;
+
+			builder.reserve(length);
+
+			for(size_t i = 0; i < length; i++)
+				builder.connect(*components[i], *components[(i + 1) % length]);
+
+			builder.commit();
+
+			return components;
+		}
+
+		/**	\brief	Builds a 2D mesh: every Component outputs to its right and lower neighbour.
+		 *
+		 *		Every inner Component has a fan-in and fan-out of 2, and a propagation from the top left corner
+		 *		is rows + columns - 2 deep, reaching most Components along many paths.
+		 *
+		 *	\param	rows, columns
+		 *		The size of the mesh.
+		 *
+		 *	\return	std::vector<Component*>
+		 *		Returns the Components row by row, (row, column) is at row * columns + column.
+		 */
+		template <class Component>
+		std::vector<Component*> mesh(Netlist<Component>& netlist, size_t rows, size_t columns, size_t initial_value = 1) {
+			std::vector<Component*>		components = createComponents(netlist, rows * columns, initial_value);
+			TopologyBuilder<Component>	builder;
+
+			builder.reserve(2 * rows * columns);
+
+			for(size_t r = 0; r < rows; r++) {
+				for(size_t c = 0; c < columns; c++) {
+					Component& node = *components[r * columns + c];
+
+					if (c + 1 < columns) builder.connect(node, *components[r * columns + c + 1]);
+					if (r + 1 < rows)	 builder.connect(node, *components[(r + 1) * columns + c]);
+				}
+			}
+
+			builder.commit();
+
+			return components;
+		}
+	}
+}
+
+#endif // SYNCHROTRONGENERATORS_HPP
@@ -0,0 +1,121 @@
+#ifndef SYNCHROTRONGRAPH_HPP
+#define SYNCHROTRONGRAPH_HPP
+
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Synchrotron {
+
+	/**	\brief	Collects every Component connected to the given ones, through inputs as well as outputs.
+	 *
+	 *	\param	first, last
+	 *		The range of Component* to start from.
+	 *
+	 *	\return	std::vector<Component*>
+	 *		Returns every connected Component once, in breadth first order.
+	 */
+	template <class Component, class InputIt>
+	std::vector<Component*> collectComponents(InputIt first, InputIt last) {
+		std::vector<Component*> nodes;
+		std::unordered_set<const Component*> seen;
+		std::deque<Component*> todo;
+
+		for(; first != last; ++first) {
+			if (seen.insert(*first).second)
+				todo.push_back(*first);
+		}
+
+		while (!todo.empty()) {
+			Component* c = todo.front();
+			todo.pop_front();
+			nodes.push_back(c);
+
+			for(auto& sender : c->getInputs()) {
+				if (seen.insert(sender).second)
+					todo.push_back(sender);
+			}
+
+			for(auto& connection : c->getOutputs()) {
+				if (seen.insert(connection).second)
+					todo.push_back(connection);
+			}
+		}
+
+		return nodes;
+	}
+
+	/**	\brief	Maps every Component in nodes to its index in nodes.
+	 *
+	 *	\param	nodes
+	 *		The Components to index.
+	 *
+	 *	\return	std::unordered_map<const Component*, size_t>
+	 *		Returns the index of every Component.
+	 */
+	template <class Component>
+	std::unordered_map<const Component*, size_t> indexComponents(const std::vector<Component*>& nodes) {
+		std::unordered_map<const Component*, size_t> index;
+		index.reserve(nodes.size());
+
+		for(size_t i = 0; i < nodes.size(); i++)
+			index.emplace(nodes[i], i);
+
+		return index;
+	}
+
+	/**	\brief	Topologically sorts nodes into levels (Kahn's algorithm).
+	 *
+	 *	Level 0 holds every Component without inputs in nodes, level n holds the Components
+	 *	whose inputs are all in a level below n. Inputs outside of nodes are ignored.
+	 *
+	 *	\param	nodes
+	 *		The Components to sort, usually from collectComponents().
+	 *	\param	levels
+	 *		Receives the levels. On a cycle, it only holds the Components in front of the cycle.
+	 *
+	 *	\return	bool
+	 *		Returns false if nodes contains a cycle.
+	 */
+	template <class Component>
+	bool levelizeComponents(const std::vector<Component*>& nodes, std::vector<std::vector<Component*>>& levels) {
+		const auto index = indexComponents(nodes);
+		std::vector<size_t> remaining(nodes.size(), 0);
+		std::vector<Component*> current;
+		size_t placed = 0;
+
+		levels.clear();
+
+		for(size_t i = 0; i < nodes.size(); i++) {
+			for(auto& sender : nodes[i]->getInputs()) {
+				if (index.count(sender))
+					remaining[i]++;
+			}
+
+			if (remaining[i] == 0)
+				current.push_back(nodes[i]);
+		}
+
+		while (!current.empty()) {
+			std::vector<Component*> next;
+
+			for(auto& c : current) {
+				for(auto& connection : c->getOutputs()) {
+					auto it = index.find(connection);
+
+					if (it != index.end() && --remaining[it->second] == 0)
+						next.push_back(connection);
+				}
+			}
+
+			placed += current.size();
+			levels.push_back(std::move(current));
+			current = std::move(next);
+		}
+
+		return placed == nodes.size();
+	}
+}
+
+#endif // SYNCHROTRONGRAPH_HPP
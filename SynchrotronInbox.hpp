@@ -0,0 +1,203 @@
+#ifndef SYNCHROTRONINBOX_HPP
+#define SYNCHROTRONINBOX_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	MpscQueue is an unbounded lock-free multi-producer single-consumer queue (Vyukov's node based queue).
+	 *
+	 *	*	push() is wait-free apart from allocating the node: one exchange and one store, whatever the contention.
+	 *	*	pop() may only be called by a single consumer thread at a time.
+	 *		A push() that is still linking its node is seen by a later pop(), never lost.
+	 *
+	 *	\param	T
+	 *		The element type.
+	 */
+	template <class T>
+	class MpscQueue {
+		private:
+			struct Node {
+				std::atomic<Node*>	next;
+				T					value;
+
+				Node() : next(nullptr), value() {}
+				explicit Node(const T& v) : next(nullptr), value(v) {}
+			};
+
+			/**	\brief
+			 *	The last pushed node, producers exchange themselves in here.
+			 */
+			std::atomic<Node*>				m_head;
+
+			// Keeps the consumer's tail off the cache line producers keep writing to
+			char							padding[64 - sizeof(std::atomic<Node*>)];
+
+			/**	\brief
+			 *	The node before the oldest element, only touched by the consumer.
+			 */
+			Node*							m_tail;
+
+		public:
+			MpscQueue() : m_head(new Node()), m_tail(m_head.load()) {}
+
+			MpscQueue(const MpscQueue&) = delete;
+			MpscQueue& operator=(const MpscQueue&) = delete;
+
+			~MpscQueue() {
+				T discard;
+				while (this->pop(discard));
+				delete this->m_tail;
+			}
+
+			/**	\brief	Appends value, from any thread.
+			 */
+			void push(const T& value) {
+				Node* node = new Node(value);
+				Node* prev = this->m_head.exchange(node, std::memory_order_acq_rel);
+				prev->next.store(node, std::memory_order_release);
+			}
+
+			/**	\brief	Takes the oldest element, from the consumer thread only.
+			 *
+			 *	\return	bool
+			 *		Returns false if the queue was empty.
+			 */
+			bool pop(T& value) {
+				Node* tail = this->m_tail;
+				Node* next = tail->next.load(std::memory_order_acquire);
+
+				if (!next)
+					return false;
+
+				value = std::move(next->value);
+				this->m_tail = next;
+				delete tail;
+
+				return true;
+			}
+
+			/**	\brief	Whether there was nothing to pop, from the consumer thread only.
+			 */
+			inline bool empty() const {
+				return this->m_tail->next.load(std::memory_order_acquire) == nullptr;
+			}
+	};
+
+	/** \brief
+	 *	InboxComponent turns tick(source) into a wait-free push of source and a copy of its state to an inbox,
+	 *	so Components on other threads can emit() into it without taking a lock.
+	 *
+	 *	The thread owning the InboxComponent calls drain(), which merges every pending input in one batch
+	 *	and emits once if the state changed. Until then, emits into it are only queued.
+	 *	drain() only reads the queued copies, never the state of an input, which its own thread may be writing.
+	 *
+	 *	Works with every virtual SynchrotronComponent variant as Base, e.g.
+	 *	`InboxComponent<SynchrotronComponentSetSort<16>>`. Connect it like a Base.
+	 *
+	 *	\param	Base
+	 *		The SynchrotronComponent variant to derive from.
+	 */
+	template <class Base>
+	class InboxComponent : public Base {
+		public:
+			typedef typename Base::combine_policy combine_policy;
+			typedef typename std::decay<decltype(std::declval<const Base&>().getState())>::type state_type;
+
+		private:
+			typedef std::pair<const Base*, state_type> input_type;
+
+			MpscQueue<input_type> inbox;
+
+			/**	\brief
+			 *	The last state every input queued, from which a non-incremental CombinePolicy reduces.
+			 *	Only touched by drain().
+			 */
+			std::unordered_map<const Base*, state_type> snapshots;
+
+		public:
+			using Base::Base;
+
+			/**	\brief	Queues the state of source, called from the thread of source by its emit().
+			 *
+			 *	\param	source
+			 *		The input that emitted.
+			 */
+			virtual void tick(Base& source) override {
+				this->inbox.push(input_type(&source, source.getState()));
+			}
+
+			/**	\brief	Applies every queued input and emits if the state changed, from the owning thread only.
+			 *
+			 *		An incremental CombinePolicy merges the queued states, otherwise CombinePolicy reduces
+			 *		the last queued state of every input once for the whole batch (so a re-implemented evaluate() is not used).
+			 *		An input that never emitted into the inbox since it was connected doesn't take part in that reduction.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of queued inputs that were applied.
+			 */
+			size_t drain() {
+				size_t count = 0;
+				input_type input;
+				const state_type prevState = this->getState();
+				state_type nextState = prevState;
+
+				while (this->inbox.pop(input)) {
+					if (combine_policy::incremental)
+						combine_policy::merge(nextState, input.second);
+					else
+						this->snapshots[input.first] = input.second;
+
+					++count;
+				}
+
+				if (count == 0)
+					return 0;
+
+				if (!combine_policy::incremental) {
+					std::unordered_map<const Base*, state_type> connected;
+					std::vector<const state_type*> states;
+
+					// Drops the snapshots of inputs that were disconnected in the meantime
+					for(auto& connection : this->getInputs()) {
+						auto it = this->snapshots.find(connection);
+
+						if (it != this->snapshots.end())
+							states.push_back(&connected.insert(*it).first->second);
+					}
+
+					this->snapshots.swap(connected);
+
+					nextState = combine_policy::reduce(prevState, states.begin(), states.end(),
+													   [](const state_type* state) -> const state_type& { return *state; });
+				}
+
+				this->setState(nextState);
+
+				if (prevState != nextState)
+					this->emit();
+
+				return count;
+			}
+
+			/**	\brief	Whether no input is queued, from the owning thread only.
+			 */
+			inline bool empty() const {
+				return this->inbox.empty();
+			}
+
+			/**	\brief	Gets the memory used by this InboxComponent, like Base::memoryUsage(), queued inputs and snapshots aside.
+			 */
+			size_t memoryUsage() const {
+				return Base::memoryUsage() + sizeof(InboxComponent) - sizeof(Base);
+			}
+	};
+}
+
+#endif // SYNCHROTRONINBOX_HPP
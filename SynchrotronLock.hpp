@@ -0,0 +1,250 @@
+#ifndef SYNCHROTRONLOCK_HPP
+#define SYNCHROTRONLOCK_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief MutexId gives every instance a unique id.
+	 *
+	 *	Includes a `static std::atomic<size_t>` with an increment when a new instance is created,
+	 *	so instances created on different threads never get the same id.
+	 *	This is used in a custom compare method `MutexId::compare` (also available as `Mutex::compare`).
+	 */
+	class MutexId {
+		protected:
+			static std::atomic<size_t> mutex_id;
+		private:
+			const size_t idx;
+		public:
+			MutexId() : idx(mutex_id.fetch_add(1, std::memory_order_relaxed))	{}
+			MutexId(const MutexId&) : MutexId()	{}
+
+			/**	\brief	Gets the unique id of this instance (its creation index).
+			 */
+			inline size_t getId() const			{ return idx;		}
+
+			/**	\brief	Gets the amount of ids handed out so far, every id is below it.
+			 */
+			static inline size_t getIdCount()	{ return mutex_id.load(std::memory_order_relaxed);	}
+
+			/**	\brief	Orders by id, and by address should two ever share one, which is also the order to lock in.
+			 */
+			struct compare {
+				inline bool operator() (const MutexId* lhs, const MutexId* rhs) const {
+					return lhs->idx != rhs->idx ? lhs->idx < rhs->idx : std::less<const MutexId*>()(lhs, rhs);
+				}
+			};
+	};
+
+	std::atomic<size_t> MutexId::mutex_id(0);
+
+	/** \brief Lock policy that doesn't lock, for single threaded use.
+	 */
+	struct NoLock {
+		inline void lock()						{}
+		inline void unlock()					{}
+	};
+
+	/** \brief Lock policy using a 1 byte test-and-test-and-set spinlock.
+	 *
+	 *	Only spins on a relaxed load while the lock is taken, so waiting threads
+	 *	don't keep stealing the cache line from the owner. Meant for short critical sections.
+	 */
+	class SpinLock {
+		private:
+			std::atomic<bool> m_flag;
+		public:
+			SpinLock() : m_flag(false)				{}
+			SpinLock(const SpinLock&) : SpinLock()	{}
+
+			inline void lock() {
+				while (m_flag.exchange(true, std::memory_order_acquire)) {
+					while (m_flag.load(std::memory_order_relaxed))
+						std::this_thread::yield();
+				}
+			}
+
+			inline void unlock()				{ m_flag.store(false, std::memory_order_release);	}
+	};
+
+	/** \brief Lock policy using a std::mutex.
+	 */
+	class StdMutexLock {
+		private:
+			std::mutex m_mutex;
+		public:
+			inline void lock()					{ m_mutex.lock();	}
+			inline void unlock()				{ m_mutex.unlock();	}
+	};
+
+	/** \brief Mutex with a non-virtual lock, selected by LockPolicy.
+	 *
+	 *	The policy is inherited, so an empty policy (NoLock) takes no space.
+	 *
+	 *	\param	LockPolicy
+	 *		The lock to use: NoLock, SpinLock or StdMutexLock.
+	 */
+	template <class LockPolicy>
+	class BasicMutex : public MutexId, private LockPolicy {
+		public:
+			typedef LockPolicy lock_policy;
+
+			BasicMutex()								{}
+			BasicMutex(const BasicMutex&) : BasicMutex()	{}
+			inline void lock()							{ LockPolicy::lock();	}
+			inline void unlock()						{ LockPolicy::unlock();	}
+	};
+
+	/**	\brief
+	 *	Creating a new BasicLockBlock(this) locks the current thread,
+	 *	while leaving the scope conveniently unlocks the thread.
+	 *
+	 *	\param	MutexType
+	 *		The type of the mutex to lock, without virtual calls.
+	 */
+	template <class MutexType>
+	class BasicLockBlock {
+		public:
+			MutexType *m_mutex;
+			BasicLockBlock(MutexType *mtx)
+				: m_mutex(mtx)		{ m_mutex->lock();		}
+			~BasicLockBlock()		{ m_mutex->unlock();	}
+	};
+
+	/**	\brief
+	 *	Creating a new BasicDualLockBlock(this, other) locks both mutexes in the order of `MutexId::compare`,
+	 *	so two threads locking the same pair (in any order) can't deadlock. Locks only once if both are the same.
+	 *
+	 *	\param	MutexType
+	 *		The type of the mutexes to lock, should derive from MutexId.
+	 */
+	template <class MutexType>
+	class BasicDualLockBlock {
+		public:
+			MutexType *m_first, *m_second;
+			BasicDualLockBlock(MutexType *a, MutexType *b)
+				: m_first(MutexId::compare()(a, b) ? a : b), m_second(MutexId::compare()(a, b) ? b : a) {
+				m_first->lock();
+				if (m_second != m_first) m_second->lock();
+			}
+			~BasicDualLockBlock() {
+				if (m_second != m_first) m_second->unlock();
+				m_first->unlock();
+			}
+	};
+
+	/**	\brief	Sorts mutexes in the order of `MutexId::compare` and drops duplicates.
+	 *
+	 *		Reads every id once up front, instead of following both pointers on every comparison.
+	 *
+	 *	\param	mutexes
+	 *		Pointers to instances deriving from MutexId.
+	 */
+	template <class T>
+	void sortByLockOrder(std::vector<T*>& mutexes) {
+		std::vector<std::pair<size_t, T*>> keyed;
+		keyed.reserve(mutexes.size());
+
+		for(auto mtx : mutexes)
+			keyed.emplace_back(mtx->getId(), mtx);
+
+		std::sort(keyed.begin(), keyed.end(), [](const std::pair<size_t, T*>& lhs, const std::pair<size_t, T*>& rhs) {
+			return lhs.first != rhs.first ? lhs.first < rhs.first : std::less<const MutexId*>()(lhs.second, rhs.second);
+		});
+
+		mutexes.clear();
+
+		for(auto& key : keyed) {
+			if (mutexes.empty() || mutexes.back() != key.second)
+				mutexes.push_back(key.second);
+		}
+	}
+
+	/**	\brief	Calls connect(target) for every target in [first, last), while self and that target are locked.
+	 *
+	 *		Holds the lock of self only once for every target that comes after it in the order of `MutexId::compare`,
+	 *		locking each of those in turn, and locks both for every target before it, so locks are always taken in order
+	 *		and nothing but self and one target is ever held. Keeps the order of the range within both groups.
+	 *
+	 *	\param	self
+	 *		The instance whose connections are edited.
+	 *	\param	first, last
+	 *		The range of targets, a target equal to self is only locked once.
+	 *	\param	connect
+	 *		Edits the connection with a target.
+	 */
+	template <class MutexType, class ForwardIt, class Function>
+	void forEachLocked(MutexType* self, ForwardIt first, ForwardIt last, Function connect) {
+		for(ForwardIt it = first; it != last; ++it) {
+			if (MutexId::compare()(*it, self)) {
+				BasicDualLockBlock<MutexType> lock(self, *it);
+				connect(*it);
+			}
+		}
+
+		BasicLockBlock<MutexType> lock(self);
+
+		for(ForwardIt it = first; it != last; ++it) {
+			if (*it == self) {
+				connect(*it);
+			} else if (!MutexId::compare()(*it, self)) {
+				BasicLockBlock<MutexType> target(*it);
+				connect(*it);
+			}
+		}
+	}
+
+	/**	\brief
+	 *	Creating a new BasicMultiLockBlock(this, first, last) locks this and every mutex in the range
+	 *	in the order of `MutexId::compare` (skipping duplicates), while leaving the scope unlocks them again.
+	 *
+	 *		Used to edit a batch of connections while taking each lock only once.
+	 *
+	 *	\param	MutexType
+	 *		The type of the mutexes to lock, should derive from MutexId.
+	 */
+	template <class MutexType>
+	class BasicMultiLockBlock {
+		private:
+			std::vector<MutexType*> m_mutexes;
+
+			void acquire() {
+				sortByLockOrder(m_mutexes);
+
+				for(auto mtx : m_mutexes) mtx->lock();
+			}
+
+		public:
+			template <class InputIt>
+			BasicMultiLockBlock(MutexType *mtx, InputIt first, InputIt last)
+				: m_mutexes(first, last) {
+				m_mutexes.push_back(mtx);
+				acquire();
+			}
+
+			template <class InputIt1, class InputIt2>
+			BasicMultiLockBlock(MutexType *mtx, InputIt1 first1, InputIt1 last1, InputIt2 first2, InputIt2 last2)
+				: m_mutexes(first1, last1) {
+				m_mutexes.insert(m_mutexes.end(), first2, last2);
+				m_mutexes.push_back(mtx);
+				acquire();
+			}
+
+			BasicMultiLockBlock(const BasicMultiLockBlock&) = delete;
+			BasicMultiLockBlock& operator=(const BasicMultiLockBlock&) = delete;
+
+			~BasicMultiLockBlock() {
+				for(auto it = m_mutexes.rbegin(); it != m_mutexes.rend(); ++it) (*it)->unlock();
+			}
+	};
+}
+
+#endif // SYNCHROTRONLOCK_HPP
@@ -0,0 +1,127 @@
+#ifndef SYNCHROTRONMEMORY_HPP
+#define SYNCHROTRONMEMORY_HPP
+
+#include <cstddef>
+#include <forward_list>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace Synchrotron {
+
+	/**	\brief	The bytes counted by every CountingAllocator on this thread, see CountingAllocator::getAllocatedBytes().
+	 */
+	inline size_t& countedBytes() {
+		static thread_local size_t bytes = 0;
+		return bytes;
+	}
+
+	/** \brief
+	 *	CountingAllocator is a std::allocator that keeps the amount of bytes it has outstanding per thread.
+	 *
+	 *	Memory::nodeSize() uses it to measure how much a node based container really allocates per element,
+	 *	which depends on the standard library (e.g. a std::set node is 40 bytes with libstdc++ on x86-64, not sizeof(T)).
+	 *	It can be the Allocator of a Component as well, to count what its connections take.
+	 *
+	 *	\param	T
+	 *		The type to allocate.
+	 */
+	template <class T>
+	class CountingAllocator {
+		public:
+			typedef T value_type;
+
+			CountingAllocator() {}
+			template <class U> CountingAllocator(const CountingAllocator<U>&) {}
+
+			/**	\brief	Gets the bytes allocated and not yet deallocated by any CountingAllocator on this thread,
+			 *		whatever its T.
+			 */
+			static inline size_t& getAllocatedBytes() {
+				return countedBytes();
+			}
+
+			T* allocate(size_t n) {
+				getAllocatedBytes() += n * sizeof(T);
+				return std::allocator<T>().allocate(n);
+			}
+
+			void deallocate(T* p, size_t n) {
+				getAllocatedBytes() -= n * sizeof(T);
+				std::allocator<T>().deallocate(p, n);
+			}
+
+			template <class U> inline bool operator==(const CountingAllocator<U>&) const	{ return true;	}
+			template <class U> inline bool operator!=(const CountingAllocator<U>&) const	{ return false;	}
+	};
+
+	/** \brief
+	 *	Memory accounts for the heap memory of the connection containers, for the memoryUsage() of the Components.
+	 *
+	 *	heapUsage() counts what a container allocates beyond its own sizeof: the nodes of node based containers,
+	 *	and the full capacity (including the spare part) of contiguous ones.
+	 *	The custom containers (SmallSet, FlatHashSet, RcuSet) report their own heapUsage().
+	 */
+	namespace Memory {
+
+		template <class T, class A>
+		inline void addElement(std::forward_list<T, A>& container) {
+			container.push_front(T());
+		}
+
+		template <class Container>
+		inline void addElement(Container& container) {
+			container.insert(container.end(), typename Container::value_type());
+		}
+
+		/**	\brief	Measures the bytes a node based Container allocates for one more element, once per Container.
+		 *
+		 *	\param	Container
+		 *		The container, with a CountingAllocator.
+		 */
+		template <class Container>
+		size_t nodeSize() {
+			static const size_t size = []() {
+				Container container;
+				const size_t before = CountingAllocator<typename Container::value_type>::getAllocatedBytes();
+
+				addElement(container);
+
+				return CountingAllocator<typename Container::value_type>::getAllocatedBytes() - before;
+			}();
+
+			return size;
+		}
+
+		template <class T, class C, class A>
+		inline size_t heapUsage(const std::set<T, C, A>& container) {
+			return container.size() * nodeSize<std::set<T, C, CountingAllocator<T>>>();
+		}
+
+		template <class T, class A>
+		inline size_t heapUsage(const std::list<T, A>& container) {
+			return container.size() * nodeSize<std::list<T, CountingAllocator<T>>>();
+		}
+
+		template <class T, class A>
+		inline size_t heapUsage(const std::forward_list<T, A>& container) {
+			return std::distance(container.begin(), container.end()) * nodeSize<std::forward_list<T, CountingAllocator<T>>>();
+		}
+
+		template <class T, class A>
+		inline size_t heapUsage(const std::vector<T, A>& container) {
+			return container.capacity() * sizeof(T);
+		}
+
+		/**	\brief	Gets the heap memory of a container that accounts for its own, e.g. FlatHashSet.
+		 */
+		template <class Container>
+		inline auto heapUsage(const Container& container) -> decltype(container.heapUsage()) {
+			return container.heapUsage();
+		}
+	}
+}
+
+#endif // SYNCHROTRONMEMORY_HPP
@@ -0,0 +1,206 @@
+#ifndef SYNCHROTRONNETLIST_HPP
+#define SYNCHROTRONNETLIST_HPP
+
+#include "SynchrotronArena.hpp"
+#include "SynchrotronStateArray.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	Netlist owns a set of Components, which are allocated from its Arena together with their connections,
+	 *	so building a netlist doesn't go through malloc for every Component and connection,
+	 *	and clear() returns all of it to the heap at once.
+	 *
+	 *	The connections only come from the Arena if the Component's Allocator can be constructed from an `Arena*`,
+	 *	e.g. `SynchrotronComponentSetSort<16, OrPolicy, StdMutexLock, ArenaAllocator<void*>>`.
+	 *	Otherwise only the Components themselves are allocated from the Arena.
+	 *
+	 *	The states of the Components are kept in a contiguous StateArray (see getStates()), in order of creation,
+	 *	if the StatePolicy of the Component is ExternalState, e.g. `SynchrotronComponentSetSort<16, OrPolicy, StdMutexLock, std::allocator<void*>, ExternalState>`.
+	 *	Such a Component only holds a reference to its slot instead of its state, and getState() and setState() keep working as before.
+	 *	Otherwise every Component keeps its own state and getStates() is empty.
+	 *
+	 *	Connections to Components outside of the Netlist are removed by clear(), but not while its Components
+	 *	are destroyed one by one outside of clear().
+	 *
+	 *	\param	Component
+	 *		The SynchrotronComponent variant to hold.
+	 */
+	template <class Component>
+	class Netlist {
+		private:
+			typedef typename Component::allocator_type allocator_type;
+
+		public:
+			typedef typename std::decay<decltype(std::declval<const Component&>().getState())>::type state_type;
+
+		private:
+
+			static_assert(alignof(Component) <= 16, "Component needs a stronger alignment than the Arena offers");
+
+			Arena arena;
+
+			/**	\brief
+			 *	The Components in order of creation.
+			 */
+			std::vector<Component*> components;
+
+			/**	\brief
+			 *	The state of every Component, same order as components.
+			 */
+			StateArray<state_type> states;
+
+			template <class A = allocator_type>
+			inline typename std::enable_if<std::is_constructible<A, Arena*>::value, A>::type makeAllocator() {
+				return A(&this->arena);
+			}
+
+			template <class A = allocator_type>
+			inline typename std::enable_if<!std::is_constructible<A, Arena*>::value, A>::type makeAllocator() {
+				return A();
+			}
+
+			template <class C = Component>
+			inline typename std::enable_if<std::is_constructible<C, state_type&, size_t, allocator_type>::value, C*>::type
+			construct(void* memory, size_t initial_value) {
+				return new (memory) C(this->states.allocate(), initial_value, this->makeAllocator());
+			}
+
+			template <class C = Component>
+			inline typename std::enable_if<!std::is_constructible<C, state_type&, size_t, allocator_type>::value, C*>::type
+			construct(void* memory, size_t initial_value) {
+				return new (memory) C(initial_value, this->makeAllocator());
+			}
+
+		public:
+			Netlist() {}
+
+			Netlist(const Netlist&) = delete;
+			Netlist& operator=(const Netlist&) = delete;
+
+			/** \brief	Destroys every Component and releases the Arena.
+			 */
+			~Netlist() {
+				this->clear();
+			}
+
+			/**	\brief	Creates a new Component in the Arena.
+			 *
+			 *	\param	initial_value
+			 *		The initial state of the Component.
+			 *
+			 *	\return	Component&
+			 *		Returns the new Component, owned by this Netlist.
+			 */
+			Component& create(size_t initial_value = 0) {
+				// Make room first, so push_back() can't throw after the Component exists
+				if (this->components.size() == this->components.capacity())
+					this->components.reserve(std::max<size_t>(16, 2 * this->components.capacity()));
+
+				void* memory = this->arena.allocate(sizeof(Component));
+				Component* component = this->construct(memory, initial_value);
+
+				this->components.push_back(component);
+
+				return *component;
+			}
+
+			/**	\brief	Destroys every Component and returns the Arena to the heap.
+			 *
+			 *		A connection between two Components of this Netlist isn't erased from either end,
+			 *		only connections to Components outside of it are, so this is O(N + E)
+			 *		instead of O(E log d) rebalancing work that would be thrown away.
+			 */
+			void clear() {
+				if (!this->components.empty()) {
+					// Components get increasing ids, so the ids of a Netlist are sorted and (nearly) contiguous
+					const size_t first = this->components.front()->getId();
+					const size_t last  = this->components.back()->getId();
+
+					std::vector<bool> owned(last - first + 1, false);
+
+					for(auto component : this->components)
+						owned[component->getId() - first] = true;
+
+					auto dying = [&](const Component* component) {
+						const size_t id = component->getId();
+						return id >= first && id <= last && owned[id - first];
+					};
+
+					for(auto component : this->components)
+						component->disconnectAll(dying);
+				}
+
+				while (!this->components.empty()) {
+					this->components.back()->~Component();
+					this->components.pop_back();
+				}
+
+				this->arena.release();
+				this->states.clear();
+			}
+
+			/**	\brief	Gets the amount of Components.
+			 */
+			inline size_t size() const {
+				return this->components.size();
+			}
+
+			/**	\brief	Gets the Components in order of creation.
+			 *
+			 *	\return	const std::vector<Component*>&
+			 *		Returns the Components, valid until clear().
+			 */
+			inline const std::vector<Component*>& getComponents() const {
+				return this->components;
+			}
+
+			/**	\brief	Gets the contiguous states of the Components, same order as getComponents().
+			 *
+			 *	\return	StateArray<state_type>&
+			 *		Returns the states, empty if Component can't keep its state in a StateArray.
+			 */
+			inline StateArray<state_type>& getStates() {
+				return this->states;
+			}
+
+			inline const StateArray<state_type>& getStates() const {
+				return this->states;
+			}
+
+			/**	\brief	Gets the Arena the Components and connections are allocated from.
+			 */
+			inline const Arena& getArena() const {
+				return this->arena;
+			}
+
+			/**	\brief	Gets the memory used by this Netlist and everything it owns.
+			 *
+			 *		Counts the slabs of the Arena (the Components, their connections if the Allocator takes the Arena,
+			 *		and the unused rest of the slabs), the StateArray, the list of Components,
+			 *		and the heap memory of the connections of every Component whose Allocator doesn't take the Arena.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of bytes.
+			 */
+			size_t memoryUsage() const {
+				size_t bytes = sizeof(*this) + this->arena.getReservedBytes() + this->states.heapUsage()
+							 + this->components.capacity() * sizeof(Component*);
+
+				if (!std::is_constructible<allocator_type, Arena*>::value) {
+					for(const Component* component : this->components)
+						bytes += component->memoryUsage() - sizeof(Component);
+				}
+
+				return bytes;
+			}
+	};
+}
+
+#endif // SYNCHROTRONNETLIST_HPP
@@ -0,0 +1,347 @@
+#ifndef SYNCHROTRONPARALLELSCHEDULER_HPP
+#define SYNCHROTRONPARALLELSCHEDULER_HPP
+
+#include "SynchrotronLock.hpp"
+#include "SynchrotronScheduler.hpp"
+#include "SynchrotronThreadPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	ParallelScheduler is the event-driven Scheduler on a ThreadPool, for sparse and irregular activity
+	 *	where a levelized pass would spend most of its time on idle levels.
+	 *
+	 *	The pending Components are propagated in delta cycles of two phases:
+	 *	*	compute: every pending Component is evaluate()d once, without changing any state,
+	 *		so evaluations within a delta cycle can't race with each other.
+	 *	*	commit: the Components whose state changed setState() the new one and schedule their outputs
+	 *		for the next delta cycle.
+	 *
+	 *	Every worker has a deque of pending Components and pops from its back, idle workers steal
+	 *	from the front of another worker's deque. An atomic pending flag per Component makes sure
+	 *	it is in at most one deque, so it is evaluated only once per delta cycle.
+	 *
+	 *	Same contract as Scheduler: only `getId()`, `getOutputs()`, `evaluate()`, `getState()` and `setState()`
+	 *	are used, so derived classes should re-implement `evaluate()` to change the logic.
+	 *	If Component re-implements tick() (see ReimplementsTick), the pending Components are tick()ed
+	 *	one by one on the calling thread instead and propagate through their own emit(), like with Scheduler,
+	 *	since such a tick() may change any state it reaches.
+	 *	Every output reached must be a Component, and the topology must not change during run().
+	 *
+	 *	\param	Component
+	 *		The SynchrotronComponent type that will be scheduled.
+	 */
+	template <class Component>
+	class ParallelScheduler {
+		public:
+			typedef typename std::decay<decltype(std::declval<const Component&>().getState())>::type state_type;
+
+		private:
+			/**	\brief
+			 *	The work of one worker, allocated on its own so workers don't share cache lines.
+			 */
+			struct Worker {
+				std::mutex										mutex;
+				std::deque<Component*>							queue;
+				std::vector<std::pair<Component*, state_type>>	computed;
+				std::vector<Component*>							overflow;
+				size_t											updates;
+				size_t											highest;
+
+				Worker() : updates(0), highest(0) {}
+			};
+
+			ThreadPool&								pool;
+			std::vector<std::unique_ptr<Worker>>	workers;
+
+			/**	\brief
+			 *	Whether a Component is already in a deque, indexed by `Mutex::getId()`.
+			 *
+			 *		Kept between runs, since every flag is false again once run() has settled.
+			 *		Only shrunk when it is far larger than the highest id scheduled since.
+			 */
+			std::unique_ptr<std::atomic<bool>[]>	pending;
+			size_t									pendingSize;
+
+			/**	\brief	Makes room for the pending flag of id, growing geometrically.
+			 *
+			 *		Must not be called while workers are running.
+			 */
+			void growPending(size_t id) {
+				if (id < this->pendingSize)
+					return;
+
+				const size_t size = std::max(id + 1, 2 * this->pendingSize);
+				std::unique_ptr<std::atomic<bool>[]> grown(new std::atomic<bool>[size]);
+
+				for(size_t i = 0; i < size; i++)
+					grown[i].store(i < this->pendingSize && this->pending[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+				this->pending.swap(grown);
+				this->pendingSize = size;
+			}
+
+			/**	\brief	Pushes c on the deque of worker w, if it wasn't pending already.
+			 *
+			 *		A Component without a pending flag yet is put aside in the overflow of worker w,
+			 *		see pushOverflow().
+			 */
+			inline void push(size_t w, Component& c) {
+				const size_t id = c.getId();
+				Worker& worker = *this->workers[w];
+
+				worker.highest = std::max(worker.highest, id);
+
+				if (id >= this->pendingSize) {
+					worker.overflow.push_back(&c);
+					return;
+				}
+
+				if (this->pending[id].exchange(true, std::memory_order_acq_rel))
+					return;
+
+				std::lock_guard<std::mutex> lock(worker.mutex);
+				worker.queue.push_back(&c);
+			}
+
+			/**	\brief	Grows the pending flags for the Components put aside by push() and pushes them.
+			 *
+			 *		Must not be called while workers are running.
+			 */
+			void pushOverflow() {
+				for(size_t w = 0; w < this->workers.size(); w++) {
+					std::vector<Component*> overflow;
+					overflow.swap(this->workers[w]->overflow);
+
+					for(Component* c : overflow) {
+						this->growPending(c->getId());
+						this->push(w, *c);
+					}
+				}
+			}
+
+			/**	\brief	Pops from the back of the own deque, or steals from the front of another one.
+			 *
+			 *	\return	Component*
+			 *		Returns nullptr once every deque is empty.
+			 */
+			Component* take(size_t w) {
+				{
+					Worker& own = *this->workers[w];
+					std::lock_guard<std::mutex> lock(own.mutex);
+
+					if (!own.queue.empty()) {
+						Component* c = own.queue.back();
+						own.queue.pop_back();
+						return c;
+					}
+				}
+
+				for(size_t i = 1; i < this->workers.size(); i++) {
+					Worker& victim = *this->workers[(w + i) % this->workers.size()];
+					std::lock_guard<std::mutex> lock(victim.mutex);
+
+					if (!victim.queue.empty()) {
+						Component* c = victim.queue.front();
+						victim.queue.pop_front();
+						return c;
+					}
+				}
+
+				return nullptr;
+			}
+
+			/**	\brief	Compute phase of worker w: evaluates pending Components until every deque is empty.
+			 */
+			void compute(size_t w) {
+				Worker& worker = *this->workers[w];
+
+				while (Component* c = this->take(w)) {
+					this->pending[c->getId()].store(false, std::memory_order_release);
+					worker.computed.emplace_back(c, c->evaluate());
+					++worker.updates;
+				}
+			}
+
+			/**	\brief	Commit phase of worker w: applies what it computed and schedules the outputs that have to follow.
+			 */
+			void commit(size_t w) {
+				Worker& worker = *this->workers[w];
+
+				for(auto& result : worker.computed) {
+					Component* c = result.first;
+
+					if (c->getState() == result.second)
+						continue;
+
+					c->setState(result.second);
+
+					for(auto& connection : c->getOutputs())
+						this->push(w, static_cast<Component&>(*connection));
+				}
+
+				worker.computed.clear();
+			}
+
+			/**	\brief	Runs one delta cycle: compute on every worker, then commit on every worker.
+			 */
+			void cycle(std::false_type) {
+				// parallelFor() only returns once every worker is done: the barrier between the phases
+				this->pool.parallelFor(0, this->workers.size(), 1, [this](size_t first, size_t last) {
+					for(size_t w = first; w < last; w++) this->compute(w);
+				});
+
+				this->pool.parallelFor(0, this->workers.size(), 1, [this](size_t first, size_t last) {
+					for(size_t w = first; w < last; w++) this->commit(w);
+				});
+
+				this->pushOverflow();
+			}
+
+			/**	\brief	Ticks every pending Component that re-implements tick() on the calling thread,
+			 *			each propagating through its own emit().
+			 */
+			void cycle(std::true_type) {
+				Worker& worker = *this->workers[0];
+
+				while (Component* c = this->take(0)) {
+					this->pending[c->getId()].store(false, std::memory_order_relaxed);
+					c->tick();
+					++worker.updates;
+				}
+			}
+
+			bool idle() const {
+				for(auto& worker : this->workers) {
+					if (!worker->queue.empty())
+						return false;
+				}
+
+				return true;
+			}
+
+		public:
+			/**	\brief	Creates a scheduler that runs on pool.
+			 *
+			 *	\param	pool
+			 *		The threads to run on, must outlive the scheduler.
+			 *	\param	queues
+			 *		The amount of deques, 0 for one per thread of pool.
+			 */
+			explicit ParallelScheduler(ThreadPool& pool, size_t queues = 0) : pool(pool), pendingSize(0) {
+				if (queues == 0)
+					queues = pool.size();
+
+				for(size_t i = 0; i < queues; i++)
+					this->workers.emplace_back(new Worker());
+			}
+
+			/**	\brief	Schedules c to be evaluated in the next delta cycle, if it wasn't pending already.
+			 *
+			 *		Must not be called during run().
+			 *
+			 *	\param	c
+			 *		The Component to update on the next run().
+			 */
+			void schedule(Component& c) {
+				this->growPending(c.getId());
+				this->push(c.getId() % this->workers.size(), c);
+			}
+
+			/**	\brief	Schedules every output of source, same as source.emit() but without recursion.
+			 *
+			 *	\param	source
+			 *		The Component whose outputs should be updated.
+			 */
+			void emit(Component& source) {
+				for(auto& connection : source.getOutputs()) {
+					this->schedule(static_cast<Component&>(*connection));
+				}
+			}
+
+			/**	\brief	Schedules c and runs until every change has been propagated.
+			 *
+			 *	\param	c
+			 *		The Component to tick.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of evaluate() (or tick()) calls that were made.
+			 */
+			size_t tick(Component& c) {
+				this->schedule(c);
+				return this->run();
+			}
+
+			/**	\brief	Runs delta cycles until no Component is pending anymore.
+			 *
+			 *	\param	limit
+			 *		The maximum amount of delta cycles to run, 0 means no limit.
+			 *		Derived logic that oscillates (e.g. a ring of inverters) will never settle without one.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of evaluate() (or tick()) calls that were made.
+			 */
+			size_t run(size_t limit = 0) {
+				for(size_t delta = 0; !this->idle() && (limit == 0 || delta < limit); delta++)
+					this->cycle(typename ReimplementsTick<Component>::type());
+
+				size_t updates = 0;
+				size_t highest = 0;
+
+				for(auto& worker : this->workers) {
+					updates += worker->updates;
+					worker->updates = 0;
+					highest = std::max(highest, worker->highest);
+				}
+
+				// Nothing is pending anymore, so every flag is false and only the size matters
+				if (this->idle()) {
+					if (this->pendingSize > 4 * (highest + 1) + 4096) {
+						this->pending.reset(new std::atomic<bool>[highest + 1]);
+						this->pendingSize = highest + 1;
+
+						for(size_t i = 0; i < this->pendingSize; i++)
+							this->pending[i].store(false, std::memory_order_relaxed);
+					}
+
+					for(auto& worker : this->workers)
+						worker->highest = 0;
+				}
+
+				return updates;
+			}
+
+			/**	\brief	Gets the amount of Components still waiting for an update.
+			 *
+			 *	\return	size_t
+			 *		Returns the total size of the deques.
+			 */
+			size_t size() const {
+				size_t count = 0;
+
+				for(auto& worker : this->workers)
+					count += worker->queue.size();
+
+				return count;
+			}
+
+			/**	\brief	Whether there are no more pending Components.
+			 *
+			 *	\return	bool
+			 *		Returns true if every deque is empty.
+			 */
+			bool empty() const {
+				return this->idle();
+			}
+	};
+}
+
+#endif // SYNCHROTRONPARALLELSCHEDULER_HPP
@@ -0,0 +1,218 @@
+#ifndef SYNCHROTRONRCUSET_HPP
+#define SYNCHROTRONRCUSET_HPP
+
+#include "SynchrotronEpoch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	RcuSet is a sorted set without duplicates for read-mostly data: readers traverse it without a lock,
+	 *	while writers copy it, change the copy and publish it (read-copy-update).
+	 *
+	 *	*	read() returns a view of the current version, which stays valid while an EpochGuard lives
+	 *		(or as long as there are no concurrent writers).
+	 *	*	insert() and erase() copy the elements: O(n). The previous version is retired to the EpochManager,
+	 *		and freed after the grace period.
+	 *	*	Writers must not run concurrently with each other: the owner serializes them (e.g. with its lock).
+	 *
+	 *	\param	T
+	 *		The element type, should be cheap to copy (e.g. a pointer).
+	 *	\param	Compare
+	 *		The ordering of the elements.
+	 */
+	template <class T, class Compare = std::less<T>>
+	class RcuSet {
+		private:
+			/**	\brief
+			 *	One published version of the elements, never changed once published.
+			 */
+			struct Snapshot {
+				std::vector<T> items;
+			};
+
+			std::atomic<Snapshot*>	m_current;
+			Compare					m_compare;
+
+			static void destroy(void* snapshot) {
+				delete static_cast<Snapshot*>(snapshot);
+			}
+
+			/**	\brief	Makes next the current version, and retires the previous one.
+			 */
+			void publish(Snapshot* next) {
+				Snapshot* prev = this->m_current.exchange(next, std::memory_order_acq_rel);
+
+				if (prev)
+					EpochManager::instance().retire(prev, &RcuSet::destroy);
+			}
+
+			/**	\brief	Copies the current version, with room for extra elements.
+			 */
+			Snapshot* copy(size_t extra) const {
+				const Snapshot* current = this->m_current.load(std::memory_order_acquire);
+				Snapshot* next = new Snapshot();
+
+				if (current) {
+					next->items.reserve(current->items.size() + extra);
+					next->items.assign(current->items.begin(), current->items.end());
+				} else {
+					next->items.reserve(extra);
+				}
+
+				return next;
+			}
+
+		public:
+			/** \brief
+			 *	A version of the elements, as a sorted contiguous range.
+			 */
+			class view {
+				private:
+					const T* m_begin;
+					const T* m_end;
+
+				public:
+					typedef T									value_type;
+					typedef const T*							const_iterator;
+					typedef const_iterator						iterator;
+					typedef std::reverse_iterator<const T*>		const_reverse_iterator;
+
+					view() : m_begin(nullptr), m_end(nullptr)						{}
+					view(const T* first, const T* last) : m_begin(first), m_end(last)	{}
+
+					inline const_iterator begin() const				{ return this->m_begin;								}
+					inline const_iterator end() const				{ return this->m_end;								}
+					inline const_iterator cbegin() const			{ return this->m_begin;								}
+					inline const_iterator cend() const				{ return this->m_end;								}
+					inline const_reverse_iterator rbegin() const	{ return const_reverse_iterator(this->m_end);		}
+					inline const_reverse_iterator rend() const		{ return const_reverse_iterator(this->m_begin);		}
+					inline const_reverse_iterator crbegin() const	{ return this->rbegin();							}
+					inline const_reverse_iterator crend() const		{ return this->rend();								}
+
+					inline size_t size() const						{ return this->m_end - this->m_begin;				}
+					inline bool empty() const						{ return this->m_begin == this->m_end;				}
+			};
+
+			RcuSet() : m_current(nullptr) {}
+
+			RcuSet(const RcuSet&) = delete;
+			RcuSet& operator=(const RcuSet&) = delete;
+
+			~RcuSet() {
+				this->publish(nullptr);
+			}
+
+			/**	\brief	Gets the current version of the elements.
+			 *
+			 *	\return	view
+			 *		Returns the elements, valid while an EpochGuard lives.
+			 */
+			inline view read() const {
+				const Snapshot* current = this->m_current.load(std::memory_order_acquire);
+
+				if (!current || current->items.empty())
+					return view();
+
+				return view(current->items.data(), current->items.data() + current->items.size());
+			}
+
+			/**	\brief	Gets the bytes of the current version, including its spare capacity.
+			 *
+			 *		Retired versions that wait for their grace period belong to the EpochManager and aren't counted.
+			 */
+			size_t heapUsage() const {
+				EpochGuard guard;
+				const Snapshot* current = this->m_current.load(std::memory_order_acquire);
+
+				return current ? sizeof(Snapshot) + current->items.capacity() * sizeof(T) : 0;
+			}
+
+			/**	\brief	Inserts value and publishes the new version, unless it is already in the set.
+			 *
+			 *	\return	bool
+			 *		Returns whether value was inserted.
+			 */
+			bool insert(const T& value) {
+				const view current = this->read();
+				const T* pos = std::lower_bound(current.begin(), current.end(), value, this->m_compare);
+
+				if (pos != current.end() && !this->m_compare(value, *pos))
+					return false;
+
+				Snapshot* next = this->copy(1);
+				next->items.insert(next->items.begin() + (pos - current.begin()), value);
+				this->publish(next);
+
+				return true;
+			}
+
+			/**	\brief	Inserts the sorted range [first, last) and publishes a single new version.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of inserted elements.
+			 */
+			template <class InputIt>
+			size_t insertSorted(InputIt first, InputIt last) {
+				const view current = this->read();
+				Snapshot* next = new Snapshot();
+
+				next->items.reserve(current.size() + std::distance(first, last));
+				std::set_union(current.begin(), current.end(), first, last, std::back_inserter(next->items), this->m_compare);
+
+				const size_t inserted = next->items.size() - current.size();
+				this->publish(next);
+
+				return inserted;
+			}
+
+			/**	\brief	Erases value and publishes the new version, if it is in the set.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of elements erased (0 or 1).
+			 */
+			size_t erase(const T& value) {
+				const view current = this->read();
+				const T* pos = std::lower_bound(current.begin(), current.end(), value, this->m_compare);
+
+				if (pos == current.end() || this->m_compare(value, *pos))
+					return 0;
+
+				if (current.size() == 1) {
+					this->publish(nullptr);
+					return 1;
+				}
+
+				Snapshot* next = this->copy(0);
+				next->items.erase(next->items.begin() + (pos - current.begin()));
+				this->publish(next);
+
+				return 1;
+			}
+
+			/**	\brief	Whether value is in the set.
+			 *
+			 *	\return	size_t
+			 *		Returns 1 if value is in the set, 0 otherwise.
+			 */
+			size_t count(const T& value) const {
+				const view current = this->read();
+				const T* pos = std::lower_bound(current.begin(), current.end(), value, this->m_compare);
+
+				return (pos != current.end() && !this->m_compare(value, *pos)) ? 1 : 0;
+			}
+
+			/**	\brief	Publishes an empty version.
+			 */
+			inline void clear() {
+				this->publish(nullptr);
+			}
+	};
+}
+
+#endif // SYNCHROTRONRCUSET_HPP
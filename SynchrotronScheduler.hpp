@@ -0,0 +1,240 @@
+#ifndef SYNCHROTRONSCHEDULER_HPP
+#define SYNCHROTRONSCHEDULER_HPP
+
+#include "SynchrotronComponent.hpp"
+#include <algorithm>
+#include <deque>
+#include <queue>
+#include <type_traits>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	First-in first-out worklist, propagates changes wave by wave (breadth first).
+	 *
+	 *	\param	Component
+	 *		The SynchrotronComponent type that will be scheduled.
+	 */
+	template <class Component>
+	class FifoWorklist {
+		private:
+			std::deque<Component*> queue;
+
+		public:
+			inline bool empty() const				{ return this->queue.empty();	}
+			inline size_t size() const				{ return this->queue.size();	}
+			inline void push(Component* c)			{ this->queue.push_back(c);		}
+
+			inline Component* pop() {
+				Component* c = this->queue.front();
+				this->queue.pop_front();
+				return c;
+			}
+	};
+
+	/** \brief
+	 *	Priority worklist, always updates the pending Component with the lowest id first.
+	 *
+	 *	Since ids are handed out on creation (see `Mutex::compare`),
+	 *	this gives the same deterministic order on every compiler.
+	 *
+	 *	\param	Component
+	 *		The SynchrotronComponent type that will be scheduled.
+	 */
+	template <class Component>
+	class PriorityWorklist {
+		private:
+			struct compare {
+				inline bool operator() (const Component* lhs, const Component* rhs) const {
+					return lhs->getId() > rhs->getId();
+				}
+			};
+
+			std::priority_queue<Component*, std::vector<Component*>, compare> queue;
+
+		public:
+			inline bool empty() const				{ return this->queue.empty();	}
+			inline size_t size() const				{ return this->queue.size();	}
+			inline void push(Component* c)			{ this->queue.push(c);			}
+
+			inline Component* pop() {
+				Component* c = this->queue.top();
+				this->queue.pop();
+				return c;
+			}
+	};
+
+	/** \brief
+	 *	Whether Component re-implements tick(), in which case the schedulers call tick() instead of update().
+	 *
+	 *	tick() is declared where getOutputs() is (the variant) unless Component or a class between them re-implements it.
+	 *	Only the scheduled type is seen, not a class derived from it.
+	 *
+	 *	\param	Component
+	 *		The SynchrotronComponent type that will be scheduled.
+	 */
+	template <class Component>
+	class ReimplementsTick {
+		private:
+			template <class C, class R> static C declaringClass(R (C::*)());
+			template <class C, class R> static C declaringClass(R (C::*)() const);
+
+		public:
+			typedef std::integral_constant<bool, !std::is_same<decltype(declaringClass(&Component::tick)),
+															   decltype(declaringClass(&Component::getOutputs))>::value> type;
+
+			static constexpr bool value = type::value;
+	};
+
+	/** \brief
+	 *	Scheduler propagates state changes iteratively instead of through recursive tick()/emit() calls.
+	 *
+	 *	Every Component is pending at most once at any time, so a Component that gets
+	 *	several inputs changed within one wave is only updated once for all of them.
+	 *	The stack usage is constant, regardless of how deep the netlist is.
+	 *
+	 *	Works with every SynchrotronComponent variant, since only `getId()`, `getOutputs()`
+	 *	and `update()` are used. Derived classes should re-implement `evaluate()` to change the logic.
+	 *	If Component re-implements tick() (see ReimplementsTick), every pending Component is tick()ed instead
+	 *	and propagates through its own emit(), recursively like without a Scheduler.
+	 *	Every output reached must be a Component, since outputs are scheduled as one.
+	 *
+	 *	\param	Component
+	 *		The SynchrotronComponent type that will be scheduled.
+	 *	\param	Worklist
+	 *		The worklist type to keep pending Components in (FifoWorklist or PriorityWorklist).
+	 */
+	template <class Component, template <class> class Worklist = FifoWorklist>
+	class Scheduler {
+		private:
+			/**	\brief
+			 *	The Components waiting for an update().
+			 */
+			Worklist<Component> worklist;
+
+			/**	\brief
+			 *	Whether a Component is already in the worklist, indexed by `Mutex::getId()`.
+			 *
+			 *		Kept between runs, since every flag is false again once run() has emptied the worklist.
+			 *		Only shrunk when it is far larger than the highest id scheduled since.
+			 */
+			std::vector<bool> pending;
+
+			/**	\brief
+			 *	The highest id scheduled since the worklist was last empty.
+			 */
+			size_t highest;
+
+			/**	\brief	Updates c and schedules its outputs if its state changed.
+			 */
+			inline void step(Component& c, std::false_type) {
+				if (c.update())
+					this->emit(c);
+			}
+
+			/**	\brief	Ticks a Component that re-implements tick(), which emits on its own.
+			 */
+			inline void step(Component& c, std::true_type) {
+				c.tick();
+			}
+
+		public:
+			Scheduler() : highest(0) {}
+
+			/**	\brief	Schedules c to be updated, if it wasn't pending already.
+			 *
+			 *	\param	c
+			 *		The Component to update on the next run().
+			 */
+			void schedule(Component& c) {
+				const size_t id = c.getId();
+
+				if (id >= this->pending.size())
+					this->pending.resize(std::max(id + 1, 2 * this->pending.size()), false);
+
+				this->highest = std::max(this->highest, id);
+
+				if (!this->pending[id]) {
+					this->pending[id] = true;
+					this->worklist.push(&c);
+				}
+			}
+
+			/**	\brief	Schedules every output of source, same as source.emit() but without recursion.
+			 *
+			 *	\param	source
+			 *		The Component whose outputs should be updated.
+			 */
+			void emit(Component& source) {
+				for(auto& connection : source.getOutputs()) {
+					this->schedule(static_cast<Component&>(*connection));
+				}
+			}
+
+			/**	\brief	Schedules c and runs until every change has been propagated.
+			 *
+			 *	\param	c
+			 *		The Component to tick.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of update() (or tick()) calls that were made.
+			 */
+			size_t tick(Component& c) {
+				this->schedule(c);
+				return this->run();
+			}
+
+			/**	\brief	Updates pending Components and schedules the outputs of those that changed,
+			 *			until the worklist is empty.
+			 *
+			 *	\param	limit
+			 *		The maximum amount of update() (or tick()) calls to make, 0 means no limit.
+			 *		Derived logic that oscillates (e.g. a ring of inverters) will never settle without one.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of update() (or tick()) calls that were made.
+			 */
+			size_t run(size_t limit = 0) {
+				size_t updates = 0;
+
+				while (!this->worklist.empty() && (limit == 0 || updates < limit)) {
+					Component* c = this->worklist.pop();
+					this->pending[c->getId()] = false;
+					++updates;
+
+					this->step(*c, typename ReimplementsTick<Component>::type());
+				}
+
+				// Nothing is pending anymore, so every flag is false and only the size matters
+				if (this->worklist.empty()) {
+					if (this->pending.size() > 4 * (this->highest + 1) + 4096)
+						std::vector<bool>(this->highest + 1, false).swap(this->pending);
+
+					this->highest = 0;
+				}
+
+				return updates;
+			}
+
+			/**	\brief	Gets the amount of Components still waiting for an update.
+			 *
+			 *	\return	size_t
+			 *		Returns the size of the worklist.
+			 */
+			size_t size() const {
+				return this->worklist.size();
+			}
+
+			/**	\brief	Whether there are no more pending Components.
+			 *
+			 *	\return	bool
+			 *		Returns true if the worklist is empty.
+			 */
+			bool empty() const {
+				return this->worklist.empty();
+			}
+	};
+}
+
+#endif // SYNCHROTRONSCHEDULER_HPP
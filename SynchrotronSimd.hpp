@@ -0,0 +1,193 @@
+#ifndef SYNCHROTRONSIMD_HPP
+#define SYNCHROTRONSIMD_HPP
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+	#define SYNCHROTRON_SIMD_X86 1
+	#include <immintrin.h>
+#endif
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	The bitwise operation a CombinePolicy folds its inputs with, for the word kernels.
+	 *	WORD_NONE means the policy can't be reduced word by word.
+	 */
+	enum WordOp {
+		WORD_NONE,
+		WORD_OR,
+		WORD_AND,
+		WORD_XOR
+	};
+
+	/**	\brief
+	 *	Whether the word kernels can be used on std::bitset, see bitsetWords().
+	 */
+#ifdef SYNCHROTRON_SIMD_X86
+	const bool SIMD_BITSETS = true;
+#else
+	const bool SIMD_BITSETS = false;
+#endif
+
+	/**	\brief
+	 *	The bit width from which FoldPolicy::reduce() uses the word kernels,
+	 *	narrower states are folded directly, which measured faster than a kernel call per batch.
+	 */
+	const size_t SIMD_MIN_BITS = 512;
+
+	/**	\brief	Gets the 64 bit words of a bitset.
+	 *
+	 *		std::bitset doesn't expose its storage, but libstdc++ and libc++ both store it as an array of
+	 *		unsigned long, which is uint64_t on x86-64. Only used where SYNCHROTRON_SIMD_X86 is defined.
+	 */
+	template <size_t N>
+	inline uint64_t* bitsetWords(std::bitset<N>& bits) {
+		static_assert(sizeof(std::bitset<N>) % sizeof(uint64_t) == 0, "std::bitset isn't stored as 64 bit words");
+		return reinterpret_cast<uint64_t*>(&bits);
+	}
+
+	template <size_t N>
+	inline const uint64_t* bitsetWords(const std::bitset<N>& bits) {
+		static_assert(sizeof(std::bitset<N>) % sizeof(uint64_t) == 0, "std::bitset isn't stored as 64 bit words");
+		return reinterpret_cast<const uint64_t*>(&bits);
+	}
+
+	namespace Simd {
+
+		template <WordOp op>
+		inline uint64_t apply(uint64_t a, uint64_t b) {
+			return op == WORD_OR ? (a | b) : op == WORD_AND ? (a & b) : (a ^ b);
+		}
+
+		/**	\brief	Scalar kernel: acc[w] = acc[w] op inputs[0][w] op ... op inputs[k-1][w], one pass over the words.
+		 */
+		template <WordOp op>
+		void reduceScalar(uint64_t* acc, const uint64_t* const* inputs, size_t k, size_t words) {
+			for(size_t w = 0; w < words; w++) {
+				uint64_t a = acc[w];
+
+				for(size_t j = 0; j < k; j++)
+					a = apply<op>(a, inputs[j][w]);
+
+				acc[w] = a;
+			}
+		}
+
+#ifdef SYNCHROTRON_SIMD_X86
+		template <WordOp op>
+		__attribute__((target("avx2"))) inline __m256i apply256(__m256i a, __m256i b) {
+			return op == WORD_OR ? _mm256_or_si256(a, b) : op == WORD_AND ? _mm256_and_si256(a, b) : _mm256_xor_si256(a, b);
+		}
+
+		/**	\brief	AVX2 kernel, 4 words at a time.
+		 */
+		template <WordOp op>
+		__attribute__((target("avx2"))) void reduceAvx2(uint64_t* acc, const uint64_t* const* inputs, size_t k, size_t words) {
+			size_t w = 0;
+
+			for(; w + 4 <= words; w += 4) {
+				__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + w));
+
+				for(size_t j = 0; j < k; j++)
+					a = apply256<op>(a, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inputs[j] + w)));
+
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + w), a);
+			}
+
+			for(; w < words; w++) {
+				for(size_t j = 0; j < k; j++)
+					acc[w] = apply<op>(acc[w], inputs[j][w]);
+			}
+		}
+
+		template <WordOp op>
+		__attribute__((target("avx512f,avx2"))) inline __m512i apply512(__m512i a, __m512i b) {
+			return op == WORD_OR ? _mm512_or_si512(a, b) : op == WORD_AND ? _mm512_and_si512(a, b) : _mm512_xor_si512(a, b);
+		}
+
+		/**	\brief	AVX-512 kernel, 8 words at a time.
+		 */
+		template <WordOp op>
+		__attribute__((target("avx512f,avx2"))) void reduceAvx512(uint64_t* acc, const uint64_t* const* inputs, size_t k, size_t words) {
+			size_t w = 0;
+
+			for(; w + 8 <= words; w += 8) {
+				__m512i a = _mm512_loadu_si512(acc + w);
+
+				for(size_t j = 0; j < k; j++)
+					a = apply512<op>(a, _mm512_loadu_si512(inputs[j] + w));
+
+				_mm512_storeu_si512(acc + w, a);
+			}
+
+			// AVX-512F implies AVX2: 4 more words at a time
+			for(; w + 4 <= words; w += 4) {
+				__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + w));
+
+				for(size_t j = 0; j < k; j++)
+					a = apply256<op>(a, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inputs[j] + w)));
+
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + w), a);
+			}
+
+			for(; w < words; w++) {
+				for(size_t j = 0; j < k; j++)
+					acc[w] = apply<op>(acc[w], inputs[j][w]);
+			}
+		}
+#endif
+
+		typedef void (*Kernel)(uint64_t*, const uint64_t* const*, size_t, size_t);
+
+		/**	\brief	Picks the widest kernel the CPU supports for op.
+		 */
+		template <WordOp op>
+		Kernel selectKernel() {
+#ifdef SYNCHROTRON_SIMD_X86
+			__builtin_cpu_init();
+
+			if (__builtin_cpu_supports("avx512f"))
+				return &reduceAvx512<op>;
+
+			if (__builtin_cpu_supports("avx2"))
+				return &reduceAvx2<op>;
+#endif
+			return &reduceScalar<op>;
+		}
+
+		/**	\brief	Gets the name of the kernel reduceWords() uses, for reports.
+		 */
+		inline const char* getKernelName() {
+#ifdef SYNCHROTRON_SIMD_X86
+			__builtin_cpu_init();
+
+			if (__builtin_cpu_supports("avx512f"))
+				return "avx512f";
+
+			if (__builtin_cpu_supports("avx2"))
+				return "avx2";
+#endif
+			return "scalar";
+		}
+	}
+
+	/**	\brief	Reduces k inputs of words 64 bit words into acc with op, in a single pass over the words.
+	 *
+	 *		Uses AVX-512 or AVX2 if the CPU supports them (checked once), the scalar kernel otherwise.
+	 *
+	 *	\param	acc
+	 *		The accumulator, words long, combined with every input.
+	 *	\param	inputs
+	 *		k pointers to the words of the inputs.
+	 */
+	template <WordOp op>
+	inline void reduceWords(uint64_t* acc, const uint64_t* const* inputs, size_t k, size_t words) {
+		static const Simd::Kernel kernel = Simd::selectKernel<op>();
+		kernel(acc, inputs, k, words);
+	}
+}
+
+#endif // SYNCHROTRONSIMD_HPP
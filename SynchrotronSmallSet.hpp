@@ -0,0 +1,201 @@
+#ifndef SYNCHROTRONSMALLSET_HPP
+#define SYNCHROTRONSMALLSET_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	SmallSet is a sorted set without duplicates that keeps up to N elements inline,
+	 *	and only spills to a (contiguous) heap array when it grows beyond that.
+	 *
+	 *	Elements are kept sorted by Compare, so with `Mutex::compare` the order is the same as
+	 *	a `std::set<T, Mutex::compare>` (see SynchrotronComponentSetSort), and iterating is a walk over an array.
+	 *	Inserting and erasing shift the elements after the position, which is cheap for the small sets
+	 *	it is meant for. Appending an element that sorts last (e.g. a newer Component) doesn't shift at all.
+	 *
+	 *	Once spilled it stays a sorted array, so inserting in the middle and erasing are O(n), not O(log n):
+	 *	removing every connection of a node with a fan-out of 10^5 one by one is quadratic and far slower than
+	 *	with a std::set. High fan-out nodes should use SynchrotronComponentSetSort or SynchrotronComponentFlatHash.
+	 *
+	 *	\param	T
+	 *		The element type, should be cheap to copy (e.g. a pointer).
+	 *	\param	N
+	 *		The amount of elements to keep inline.
+	 *	\param	Compare
+	 *		The ordering of the elements.
+	 *	\param	Allocator
+	 *		The allocator of the heap array.
+	 */
+	template <class T, size_t N, class Compare = std::less<T>, class Allocator = std::allocator<T>>
+	class SmallSet {
+		public:
+			typedef T							value_type;
+			typedef size_t						size_type;
+			typedef const T*					const_iterator;
+			typedef const_iterator				iterator;
+			typedef std::reverse_iterator<const_iterator>	const_reverse_iterator;
+			typedef const_reverse_iterator		reverse_iterator;
+			typedef Allocator					allocator_type;
+
+		private:
+			typedef std::allocator_traits<Allocator> traits;
+
+			T*			m_data;
+			size_t		m_size;
+			size_t		m_capacity;
+			T			m_inline[N];
+			Compare		m_compare;
+			Allocator	m_alloc;
+
+			inline bool isInline() const {
+				return this->m_data == this->m_inline;
+			}
+
+			inline T* lowerBound(const T& value) {
+				return std::lower_bound(this->m_data, this->m_data + this->m_size, value, this->m_compare);
+			}
+
+			/**	\brief	Moves the elements to a heap array of the given capacity.
+			 */
+			void grow(size_t capacity) {
+				T* data = traits::allocate(this->m_alloc, capacity);
+
+				std::move(this->m_data, this->m_data + this->m_size, data);
+
+				this->release();
+
+				this->m_data     = data;
+				this->m_capacity = capacity;
+			}
+
+			/**	\brief	Returns the heap array, if any.
+			 */
+			inline void release() {
+				if (!this->isInline())
+					traits::deallocate(this->m_alloc, this->m_data, this->m_capacity);
+			}
+
+		public:
+			SmallSet() : m_data(m_inline), m_size(0), m_capacity(N) {}
+			explicit SmallSet(const Allocator& alloc) : m_data(m_inline), m_size(0), m_capacity(N), m_alloc(alloc) {}
+
+			SmallSet(const SmallSet&) = delete;
+			SmallSet& operator=(const SmallSet&) = delete;
+
+			~SmallSet() {
+				this->release();
+			}
+
+			inline allocator_type get_allocator() const			{ return this->m_alloc;								}
+
+			inline const_iterator begin() const					{ return this->m_data;								}
+			inline const_iterator end() const					{ return this->m_data + this->m_size;				}
+			inline const_iterator cbegin() const				{ return this->begin();								}
+			inline const_iterator cend() const					{ return this->end();								}
+			inline const_reverse_iterator rbegin() const		{ return const_reverse_iterator(this->end());		}
+			inline const_reverse_iterator rend() const			{ return const_reverse_iterator(this->begin());		}
+			inline const_reverse_iterator crbegin() const		{ return this->rbegin();							}
+			inline const_reverse_iterator crend() const			{ return this->rend();								}
+
+			inline size_t size() const							{ return this->m_size;								}
+			inline size_t capacity() const						{ return this->m_capacity;							}
+			inline bool empty() const							{ return this->m_size == 0;							}
+
+			/**	\brief	Whether the elements no longer fit inline and have been moved to the heap.
+			 */
+			inline bool spilled() const							{ return !this->isInline();							}
+
+			/**	\brief	Gets the bytes of the heap array, 0 while the elements are inline.
+			 */
+			inline size_t heapUsage() const						{ return this->spilled() ? this->m_capacity * sizeof(T) : 0;	}
+
+			/**	\brief	Makes room for at least capacity elements, so they can be inserted without growing.
+			 */
+			void reserve(size_t capacity) {
+				if (capacity > this->m_capacity)
+					this->grow(std::max(capacity, this->m_capacity * 2));
+			}
+
+			/**	\brief	Inserts value, unless it is already in the set.
+			 *
+			 *	\return	std::pair<const_iterator, bool>
+			 *		Returns the position of value and whether it was inserted.
+			 */
+			std::pair<const_iterator, bool> insert(const T& value) {
+				T* pos;
+
+				if (this->m_size == 0 || this->m_compare(this->m_data[this->m_size - 1], value)) {
+					pos = this->m_data + this->m_size;
+				} else {
+					pos = this->lowerBound(value);
+
+					if (!this->m_compare(value, *pos))
+						return std::make_pair(const_iterator(pos), false);
+				}
+
+				if (this->m_size == this->m_capacity) {
+					const size_t offset = pos - this->m_data;
+					this->grow(this->m_capacity * 2);
+					pos = this->m_data + offset;
+				}
+
+				std::move_backward(pos, this->m_data + this->m_size, this->m_data + this->m_size + 1);
+				*pos = value;
+				++this->m_size;
+
+				return std::make_pair(const_iterator(pos), true);
+			}
+
+			/**	\brief	Same as insert(value), the hint is ignored (for compatibility with std::set).
+			 */
+			inline const_iterator insert(const_iterator, const T& value) {
+				return this->insert(value).first;
+			}
+
+			/**	\brief	Erases value, if it is in the set.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of elements erased (0 or 1).
+			 */
+			size_t erase(const T& value) {
+				T* pos = this->lowerBound(value);
+
+				if (pos == this->m_data + this->m_size || this->m_compare(value, *pos))
+					return 0;
+
+				std::move(pos + 1, this->m_data + this->m_size, pos);
+				--this->m_size;
+
+				return 1;
+			}
+
+			/**	\brief	Whether value is in the set.
+			 *
+			 *	\return	size_t
+			 *		Returns 1 if value is in the set, 0 otherwise.
+			 */
+			size_t count(const T& value) const {
+				const T* pos = std::lower_bound(this->begin(), this->end(), value, this->m_compare);
+
+				return (pos != this->end() && !this->m_compare(value, *pos)) ? 1 : 0;
+			}
+
+			/**	\brief	Removes every element and returns to the inline storage.
+			 */
+			void clear() {
+				this->release();
+
+				this->m_data     = this->m_inline;
+				this->m_size     = 0;
+				this->m_capacity = N;
+			}
+	};
+}
+
+#endif // SYNCHROTRONSMALLSET_HPP
@@ -0,0 +1,191 @@
+#ifndef SYNCHROTRONSTATEARRAY_HPP
+#define SYNCHROTRONSTATEARRAY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	State policies decide where a SynchrotronComponent keeps its state, as its StatePolicy template argument.
+	 *	Each offers a base class `storage<T>`, whose `state` member of type T is the state the Component reads and writes.
+	 *
+	 *	InlineState keeps the state inside the Component, the default.
+	 */
+	struct InlineState {
+		static const bool external = false;
+
+		template <class T>
+		class storage {
+			protected:
+				T state;
+
+				explicit storage(size_t initial_value) : state(initial_value) {}
+		};
+	};
+
+	/** \brief
+	 *	ExternalState keeps the state in a slot given on construction (e.g. by a Netlist, in its StateArray),
+	 *	so the Component only holds a reference to it instead of the state itself.
+	 *
+	 *	Such a Component can only be created with the state storage constructor, so not copied either.
+	 */
+	struct ExternalState {
+		static const bool external = true;
+
+		template <class T>
+		class storage {
+			protected:
+				T& state;
+
+				storage(T& slot, size_t initial_value) : state(slot) {
+					this->state = T(initial_value);
+				}
+		};
+	};
+
+	/** \brief
+	 *	StateArray keeps the states of a whole Netlist next to each other, in chunks of chunk_size states.
+	 *
+	 *	A pass over the states (a snapshot, a diff, a reduction) is then a linear pass over a few
+	 *	contiguous blocks, instead of touching the cache line of every Component.
+	 *	New states are added in chunks, so the slots handed out by allocate() never move.
+	 *
+	 *	\param	T
+	 *		The state type, e.g. std::bitset<bit_width>.
+	 *	\param	chunk_size
+	 *		The amount of states per chunk.
+	 */
+	template <class T, size_t chunk_size = 4096>
+	class StateArray {
+		private:
+			std::vector<std::unique_ptr<T[]>> chunks;
+			size_t count;
+
+		public:
+			typedef T value_type;
+
+			StateArray() : count(0) {}
+
+			StateArray(const StateArray&) = delete;
+			StateArray& operator=(const StateArray&) = delete;
+
+			/**	\brief	Adds a state, value initialized.
+			 *
+			 *	\return	T&
+			 *		Returns the new slot, valid until clear().
+			 */
+			T& allocate() {
+				if (this->count == this->chunks.size() * chunk_size)
+					this->chunks.emplace_back(new T[chunk_size]());
+
+				T& slot = (*this)[this->count++];
+				slot = T();
+
+				return slot;
+			}
+
+			/**	\brief	Drops every state and chunk.
+			 */
+			void clear() {
+				this->chunks.clear();
+				this->count = 0;
+			}
+
+			/**	\brief	Gets the amount of states.
+			 */
+			inline size_t size() const {
+				return this->count;
+			}
+
+			inline T& operator[](size_t i) {
+				return this->chunks[i / chunk_size][i % chunk_size];
+			}
+
+			inline const T& operator[](size_t i) const {
+				return this->chunks[i / chunk_size][i % chunk_size];
+			}
+
+			/**	\brief	Gets the bytes of the chunks, including the unused part of the last one.
+			 */
+			inline size_t heapUsage() const {
+				return this->chunks.capacity() * sizeof(std::unique_ptr<T[]>) + this->chunks.size() * chunk_size * sizeof(T);
+			}
+
+			/**	\brief	Gets the amount of chunks.
+			 */
+			inline size_t getChunkCount() const {
+				return this->chunks.size();
+			}
+
+			/**	\brief	Gets the states in chunk c, contiguous.
+			 *
+			 *	\return	T*
+			 *		Returns the first of getChunkSize(c) states.
+			 */
+			inline T* getChunk(size_t c) {
+				return this->chunks[c].get();
+			}
+
+			inline const T* getChunk(size_t c) const {
+				return this->chunks[c].get();
+			}
+
+			/**	\brief	Gets the amount of states in chunk c, chunk_size for all but the last chunk.
+			 */
+			inline size_t getChunkSize(size_t c) const {
+				return std::min(chunk_size, this->count - c * chunk_size);
+			}
+
+			/**	\brief	Copies every state into snapshot, in order.
+			 */
+			void snapshot(std::vector<T>& snapshot) const {
+				snapshot.resize(this->count);
+
+				for(size_t c = 0; c < this->chunks.size(); c++)
+					std::copy(this->getChunk(c), this->getChunk(c) + this->getChunkSize(c), snapshot.begin() + c * chunk_size);
+			}
+
+			/**	\brief	Copies the states from snapshot back, without emitting.
+			 *
+			 *	\param	snapshot
+			 *		A snapshot() of this array, with the same size.
+			 */
+			void restore(const std::vector<T>& snapshot) {
+				for(size_t c = 0; c < this->chunks.size(); c++)
+					std::copy(snapshot.begin() + c * chunk_size, snapshot.begin() + c * chunk_size + this->getChunkSize(c), this->getChunk(c));
+			}
+
+			/**	\brief	Compares every state with snapshot.
+			 *
+			 *	\param	snapshot
+			 *		A snapshot() of this array, with the same size.
+			 *	\param	changed
+			 *		If not null, receives the index of every state that differs.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of states that differ.
+			 */
+			size_t diff(const std::vector<T>& snapshot, std::vector<size_t>* changed = nullptr) const {
+				size_t differences = 0;
+
+				for(size_t c = 0; c < this->chunks.size(); c++) {
+					const T* states = this->getChunk(c);
+					const T* before = snapshot.data() + c * chunk_size;
+
+					for(size_t i = 0; i < this->getChunkSize(c); i++) {
+						if (states[i] != before[i]) {
+							++differences;
+							if (changed) changed->push_back(c * chunk_size + i);
+						}
+					}
+				}
+
+				return differences;
+			}
+	};
+}
+
+#endif // SYNCHROTRONSTATEARRAY_HPP
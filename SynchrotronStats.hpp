@@ -0,0 +1,274 @@
+#ifndef SYNCHROTRONSTATS_HPP
+#define SYNCHROTRONSTATS_HPP
+
+/**
+ *	Hot path counters, only compiled in when SYNCHROTRON_STATS is defined (e.g. -DSYNCHROTRON_STATS).
+ *	Otherwise the SYNCHROTRON_STATS_* macros expand to a no-op and their arguments aren't evaluated.
+ *
+ *	*	SYNCHROTRON_STATS_TICK(changed)		A state update, by tick(), tick(source) or a scheduler, and whether it changed the state.
+ *	*	SYNCHROTRON_STATS_EVALUATE(fan_in)	A reduction of fan_in inputs by evaluate().
+ *	*	SYNCHROTRON_STATS_EMIT(fan_out)		An emit() to fan_out outputs, counted as one level of propagation depth until the end of the scope.
+ */
+#ifdef SYNCHROTRON_STATS
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace Synchrotron {
+namespace Stats {
+
+	/**	\brief
+	 *	The amount of histogram buckets: bucket 0 counts 0, bucket b counts [2^(b-1), 2^b), the last one everything above.
+	 */
+	const size_t BUCKETS = 16;
+
+	inline size_t bucket(size_t n) {
+		size_t b = 0;
+
+		for(; n && b < BUCKETS - 1; n >>= 1)
+			++b;
+
+		return b;
+	}
+
+	/** \brief
+	 *	The counters of one thread, on cache lines of their own so threads never write to the same line.
+	 *
+	 *	Only the owning thread writes them, with a relaxed load and store instead of an atomic read-modify-write,
+	 *	other threads may read them at any time.
+	 */
+	struct alignas(64) Counters {
+		std::atomic<uint64_t>	ticks;
+		std::atomic<uint64_t>	unchangedTicks;
+		std::atomic<uint64_t>	evaluations;
+		std::atomic<uint64_t>	emits;
+		std::atomic<uint64_t>	maxDepth;
+		std::atomic<uint64_t>	fanIn[BUCKETS];
+		std::atomic<uint64_t>	fanOut[BUCKETS];
+		std::atomic<uint64_t>	depth[BUCKETS];
+
+		Counters() {
+			this->reset();
+		}
+
+		void reset() {
+			this->ticks				= 0;
+			this->unchangedTicks	= 0;
+			this->evaluations		= 0;
+			this->emits				= 0;
+			this->maxDepth			= 0;
+
+			for(size_t b = 0; b < BUCKETS; b++) {
+				this->fanIn[b]	= 0;
+				this->fanOut[b]	= 0;
+				this->depth[b]	= 0;
+			}
+		}
+	};
+
+	inline void add(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+		counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+
+	/** \brief
+	 *	Registry holds the Counters of every thread, like the EpochManager holds its Records.
+	 *
+	 *	A thread claims Counters on first use and releases them when it exits, the next thread continues counting in them,
+	 *	so the totals include exited threads. Threads beyond MAX_THREADS share the last Counters, and may lose counts to each other.
+	 */
+	class Registry {
+		public:
+			static const size_t MAX_THREADS = 256;
+
+		private:
+			struct Slot {
+				Counters			counters;
+				std::atomic<bool>	claimed;
+			};
+
+			Slot slots[MAX_THREADS];
+
+			/**	\brief
+			 *	Claims Counters for the current thread, and releases them when the thread exits.
+			 */
+			struct ThreadSlot {
+				Slot* slot;
+
+				ThreadSlot() : slot(nullptr) {
+					Registry& registry = Registry::instance();
+
+					for(auto& s : registry.slots) {
+						bool expected = false;
+						if (s.claimed.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+							this->slot = &s;
+							return;
+						}
+					}
+
+					this->slot = &registry.slots[MAX_THREADS - 1];
+				}
+
+				~ThreadSlot() {
+					this->slot->claimed.store(false, std::memory_order_release);
+				}
+			};
+
+			Registry() {
+				for(auto& s : this->slots) s.claimed = false;
+			}
+
+		public:
+			static Registry& instance() {
+				static Registry registry;
+				return registry;
+			}
+
+			/**	\brief	Gets the Counters of the calling thread.
+			 */
+			static Counters& local() {
+				static thread_local ThreadSlot slot;
+				return slot.slot->counters;
+			}
+
+			template <class F>
+			void forEach(F f) {
+				for(auto& s : this->slots)
+					f(s.counters);
+			}
+	};
+
+	/**	\brief	Gets the Counters of the calling thread.
+	 */
+	inline Counters& local() {
+		return Registry::local();
+	}
+
+	/**	\brief	Gets the current amount of nested emit()s on the calling thread.
+	 */
+	inline size_t& currentDepth() {
+		static thread_local size_t depth = 0;
+		return depth;
+	}
+
+	/** \brief
+	 *	The sum of the Counters of every thread.
+	 */
+	struct Totals {
+		uint64_t	ticks;
+		uint64_t	unchangedTicks;
+		uint64_t	evaluations;
+		uint64_t	emits;
+		uint64_t	maxDepth;
+		uint64_t	fanIn[BUCKETS];
+		uint64_t	fanOut[BUCKETS];
+		uint64_t	depth[BUCKETS];
+	};
+
+	/**	\brief	Sums the Counters of every thread, while they keep counting.
+	 */
+	inline Totals collect() {
+		Totals totals = Totals();
+
+		Registry::instance().forEach([&](const Counters& c) {
+			totals.ticks			+= c.ticks.load(std::memory_order_relaxed);
+			totals.unchangedTicks	+= c.unchangedTicks.load(std::memory_order_relaxed);
+			totals.evaluations		+= c.evaluations.load(std::memory_order_relaxed);
+			totals.emits			+= c.emits.load(std::memory_order_relaxed);
+
+			if (c.maxDepth.load(std::memory_order_relaxed) > totals.maxDepth)
+				totals.maxDepth = c.maxDepth.load(std::memory_order_relaxed);
+
+			for(size_t b = 0; b < BUCKETS; b++) {
+				totals.fanIn[b]		+= c.fanIn[b].load(std::memory_order_relaxed);
+				totals.fanOut[b]	+= c.fanOut[b].load(std::memory_order_relaxed);
+				totals.depth[b]		+= c.depth[b].load(std::memory_order_relaxed);
+			}
+		});
+
+		return totals;
+	}
+
+	/**	\brief	Zeroes the Counters of every thread, while none of them counts (counts in flight may be lost otherwise).
+	 */
+	inline void reset() {
+		Registry::instance().forEach([](Counters& c) { c.reset(); });
+	}
+
+	/**	\brief	Prints the totals and the non-empty histogram buckets.
+	 */
+	inline void print(FILE* out = stdout) {
+		const Totals t = collect();
+
+		fprintf(out, "ticks %llu (unchanged %llu), evaluations %llu, emits %llu, max depth %llu\n",
+				(unsigned long long) t.ticks, (unsigned long long) t.unchangedTicks, (unsigned long long) t.evaluations,
+				(unsigned long long) t.emits, (unsigned long long) t.maxDepth);
+		fprintf(out, "%14s %14s %14s %14s\n", "bucket", "fan-in", "fan-out", "depth");
+
+		for(size_t b = 0; b < BUCKETS; b++) {
+			if (!t.fanIn[b] && !t.fanOut[b] && !t.depth[b])
+				continue;
+
+			const unsigned long long low = b ? 1ull << (b - 1) : 0;
+			fprintf(out, "%13llu+ %14llu %14llu %14llu\n", low,
+					(unsigned long long) t.fanIn[b], (unsigned long long) t.fanOut[b], (unsigned long long) t.depth[b]);
+		}
+	}
+
+	inline void tick(bool changed) {
+		Counters& c = local();
+
+		add(c.ticks);
+		if (!changed) add(c.unchangedTicks);
+	}
+
+	inline void evaluate(size_t fan_in) {
+		Counters& c = local();
+
+		add(c.evaluations);
+		add(c.fanIn[bucket(fan_in)]);
+	}
+
+	/** \brief
+	 *	EmitScope counts an emit(), and its depth in the propagation for as long as it lives.
+	 */
+	class EmitScope {
+		private:
+			Counters& c;
+
+		public:
+			explicit EmitScope(size_t fan_out) : c(local()) {
+				const size_t depth = ++currentDepth();
+
+				add(this->c.emits);
+				add(this->c.fanOut[bucket(fan_out)]);
+				add(this->c.depth[bucket(depth)]);
+
+				if (depth > this->c.maxDepth.load(std::memory_order_relaxed))
+					this->c.maxDepth.store(depth, std::memory_order_relaxed);
+			}
+
+			~EmitScope() {
+				--currentDepth();
+			}
+
+			EmitScope(const EmitScope&) = delete;
+			EmitScope& operator=(const EmitScope&) = delete;
+	};
+}
+}
+
+#define SYNCHROTRON_STATS_TICK(changed)		Synchrotron::Stats::tick(changed)
+#define SYNCHROTRON_STATS_EVALUATE(fan_in)	Synchrotron::Stats::evaluate(fan_in)
+#define SYNCHROTRON_STATS_EMIT(fan_out)		Synchrotron::Stats::EmitScope synchrotron_stats_emit(fan_out)
+
+#else
+
+#define SYNCHROTRON_STATS_TICK(changed)		((void) 0)
+#define SYNCHROTRON_STATS_EVALUATE(fan_in)	((void) 0)
+#define SYNCHROTRON_STATS_EMIT(fan_out)		((void) 0)
+
+#endif // SYNCHROTRON_STATS
+
+#endif // SYNCHROTRONSTATS_HPP
@@ -0,0 +1,195 @@
+#ifndef SYNCHROTRONTHREADPOOL_HPP
+#define SYNCHROTRONTHREADPOOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	ThreadPool keeps a set of worker threads around to run parallelFor() loops,
+	 *	so a parallel loop per level doesn't have to start threads.
+	 *
+	 *	parallelFor() hands out chunks of the range from an atomic counter to the workers and the calling thread,
+	 *	and only returns once every worker has finished: a barrier at the end of every loop.
+	 *
+	 *	Only one thread should call parallelFor() at a time.
+	 */
+	class ThreadPool {
+		private:
+			std::vector<std::thread>	workers;
+
+			std::mutex					m_mutex;
+			std::condition_variable		m_wake;
+			size_t						m_generation;
+			bool						m_stop;
+
+			/**	\brief
+			 *	The current loop: m_run(m_job, first, last) for every chunk of [m_begin, m_end).
+			 */
+			void						(*m_run)(void*, size_t, size_t);
+			void*						m_job;
+			size_t						m_begin;
+			size_t						m_end;
+			size_t						m_grain;
+
+			// Written by every thread, so kept off the cache line of the loop description
+			alignas(64) std::atomic<size_t>	m_next;
+			alignas(64) std::atomic<size_t>	m_busy;
+
+			template <class F>
+			static void run(void* job, size_t first, size_t last) {
+				(*static_cast<F*>(job))(first, last);
+			}
+
+			/**	\brief	Runs chunks of the current loop until there are none left.
+			 */
+			void work() {
+				for(;;) {
+					const size_t first = this->m_begin + this->m_next.fetch_add(1) * this->m_grain;
+
+					if (first >= this->m_end)
+						return;
+
+					this->m_run(this->m_job, first, std::min(first + this->m_grain, this->m_end));
+				}
+			}
+
+			void loop() {
+				size_t generation = 0;
+
+				for(;;) {
+					{
+						std::unique_lock<std::mutex> lock(this->m_mutex);
+						this->m_wake.wait(lock, [&]() { return this->m_stop || this->m_generation != generation; });
+
+						if (this->m_stop)
+							return;
+
+						generation = this->m_generation;
+					}
+
+					this->work();
+					this->m_busy.fetch_sub(1, std::memory_order_release);
+				}
+			}
+
+		public:
+			/**	\brief	Starts threads - 1 workers, the thread calling parallelFor() is the last one.
+			 *
+			 *	\param	threads
+			 *		The amount of threads to run loops on, 0 for one per hardware thread.
+			 */
+			explicit ThreadPool(size_t threads = 0)
+				: m_generation(0), m_stop(false), m_run(nullptr), m_job(nullptr),
+				  m_begin(0), m_end(0), m_grain(1), m_next(0), m_busy(0) {
+				if (threads == 0)
+					threads = std::max(1u, std::thread::hardware_concurrency());
+
+				for(size_t i = 1; i < threads; i++)
+					this->workers.emplace_back(&ThreadPool::loop, this);
+			}
+
+			ThreadPool(const ThreadPool&) = delete;
+			ThreadPool& operator=(const ThreadPool&) = delete;
+
+			~ThreadPool() {
+				{
+					std::lock_guard<std::mutex> lock(this->m_mutex);
+					this->m_stop = true;
+				}
+
+				this->m_wake.notify_all();
+
+				for(auto& worker : this->workers)
+					worker.join();
+			}
+
+			/**	\brief	Gets the amount of threads loops run on, including the calling thread.
+			 */
+			inline size_t size() const {
+				return this->workers.size() + 1;
+			}
+
+			/**	\brief	Calls f(first, last) for chunks of grain indices covering [begin, end), in parallel.
+			 *
+			 *		Returns once every chunk is done. Runs on the calling thread only if there is only one chunk.
+			 *
+			 *	\param	begin, end
+			 *		The range of indices.
+			 *	\param	grain
+			 *		The amount of indices per chunk, the chunks start at begin + k * grain.
+			 *	\param	f
+			 *		Called with the bounds of each chunk, from several threads at once.
+			 */
+			template <class F>
+			void parallelFor(size_t begin, size_t end, size_t grain, F f) {
+				if (begin >= end)
+					return;
+
+				grain = std::max<size_t>(grain, 1);
+
+				if (this->workers.empty() || end - begin <= grain) {
+					f(begin, end);
+					return;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(this->m_mutex);
+					this->m_run   = &ThreadPool::run<F>;
+					this->m_job   = &f;
+					this->m_begin = begin;
+					this->m_end   = end;
+					this->m_grain = grain;
+					this->m_next.store(0);
+					this->m_busy.store(this->workers.size());
+					++this->m_generation;
+				}
+
+				this->m_wake.notify_all();
+				this->work();
+
+				// Barrier: f and the loop description must stay valid until every worker is done
+				while (this->m_busy.load(std::memory_order_acquire) != 0)
+					std::this_thread::yield();
+			}
+
+			/**	\brief	Calls f(first, last) for chunks of [begin, end) that start on a cache line of data, in parallel.
+			 *
+			 *		Two threads never write to the same cache line of data, as long as f only writes data[first .. last].
+			 *
+			 *	\param	data
+			 *		The array that is written, indexed by the range.
+			 *	\param	begin, end
+			 *		The range of indices.
+			 *	\param	lines_per_chunk
+			 *		The amount of cache lines of data per chunk, more means less scheduling overhead per chunk.
+			 *	\param	f
+			 *		Called with the bounds of each chunk, from several threads at once.
+			 */
+			template <class T, class F>
+			void parallelForLines(const T* data, size_t begin, size_t end, size_t lines_per_chunk, F f) {
+				const size_t line     = 64;
+				const size_t per_line = std::max<size_t>(line / sizeof(T), 1);
+				const size_t grain    = per_line * std::max<size_t>(lines_per_chunk, 1);
+
+				// Elements i with (i + pad) % per_line == 0 start a cache line
+				const size_t pad = reinterpret_cast<std::uintptr_t>(data) % line / sizeof(T) % per_line;
+
+				// Chunks over i + pad, starting at the line begin is on, the first one is clipped to the range
+				const size_t origin = (begin + pad) / per_line * per_line;
+
+				this->parallelFor(origin, end + pad, grain, [&](size_t first, size_t last) {
+					f(std::max(first, begin + pad) - pad, last - pad);
+				});
+			}
+	};
+}
+
+#endif // SYNCHROTRONTHREADPOOL_HPP
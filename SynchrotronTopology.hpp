@@ -0,0 +1,150 @@
+#ifndef SYNCHROTRONTOPOLOGY_HPP
+#define SYNCHROTRONTOPOLOGY_HPP
+
+#include "SynchrotronFlatHashSet.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Synchrotron {
+
+	/** \brief
+	 *	TopologyBuilder collects connections, and adds them all at once with commit().
+	 *
+	 *	commit() connects every source to all of its outputs with a single addOutput(first, last),
+	 *	after dropping duplicate connections in O(1) each. The connections are only sorted (stably, by the id of the source)
+	 *	if the same source shows up in more than one run of the pending connections, fanOut() and connect() in a loop
+	 *	over the outputs of one source keep them grouped already.
+	 *
+	 *	Not thread safe itself: use one builder per thread.
+	 *
+	 *	\param	Component
+	 *		The SynchrotronComponent variant to connect.
+	 */
+	template <class Component>
+	class TopologyBuilder {
+		private:
+			typedef std::pair<Component*, Component*> Edge;
+
+			/**	\brief
+			 *	The pending connections, as (output of, input of).
+			 */
+			std::vector<Edge> edges;
+
+			/**	\brief	Whether the connections of every source are next to each other already.
+			 */
+			bool grouped() const {
+				bool increasing = true;
+
+				// Sources in order of creation, as connected by a loop over the Components of a Netlist
+				for(size_t i = 1; i < this->edges.size() && increasing; i++) {
+					if (this->edges[i].first != this->edges[i - 1].first)
+						increasing = this->edges[i - 1].first->getId() < this->edges[i].first->getId();
+				}
+
+				if (increasing)
+					return true;
+
+				FlatHashSet<Component*> sources;
+
+				for(size_t i = 0; i < this->edges.size(); i++) {
+					if ((i == 0 || this->edges[i].first != this->edges[i - 1].first) && !sources.insert(this->edges[i].first))
+						return false;
+				}
+
+				return true;
+			}
+
+			/**	\brief	Groups the connections by source, in order of the ids of the sources, keeping their order within a source.
+			 */
+			void group() {
+				// The id of the source, read once per connection instead of on every comparison
+				std::vector<std::pair<size_t, Edge>> keyed;
+				keyed.reserve(this->edges.size());
+
+				for(auto& edge : this->edges)
+					keyed.emplace_back(edge.first->getId(), edge);
+
+				std::stable_sort(keyed.begin(), keyed.end(), [](const std::pair<size_t, Edge>& lhs, const std::pair<size_t, Edge>& rhs) {
+					return lhs.first < rhs.first;
+				});
+
+				for(size_t i = 0; i < keyed.size(); i++)
+					this->edges[i] = keyed[i].second;
+			}
+
+		public:
+			/**	\brief	Makes room for count connections.
+			 */
+			inline void reserve(size_t count) {
+				this->edges.reserve(count);
+			}
+
+			/**	\brief	Adds a connection from the output of from to the input of to.
+			 */
+			inline void connect(Component& from, Component& to) {
+				this->edges.emplace_back(&from, &to);
+			}
+
+			/**	\brief	Adds connections from the output of from to every Component* in the range.
+			 */
+			template <class InputIt>
+			void fanOut(Component& from, InputIt first, InputIt last) {
+				for(; first != last; ++first)
+					this->edges.emplace_back(&from, *first);
+			}
+
+			/**	\brief	Adds connections from every Component* in the range to the input of to.
+			 */
+			template <class InputIt>
+			void fanIn(InputIt first, InputIt last, Component& to) {
+				for(; first != last; ++first)
+					this->edges.emplace_back(*first, &to);
+			}
+
+			/**	\brief	Gets the amount of pending connections, including duplicates.
+			 */
+			inline size_t size() const {
+				return this->edges.size();
+			}
+
+			/**	\brief	Drops the pending connections.
+			 */
+			inline void clear() {
+				this->edges.clear();
+			}
+
+			/**	\brief	Adds every pending connection to its Components.
+			 *
+			 *	\return	size_t
+			 *		Returns the amount of distinct connections that were added.
+			 */
+			size_t commit() {
+				if (!this->grouped())
+					this->group();
+
+				std::vector<Component*> outputs;
+				size_t count = 0;
+
+				for(auto it = this->edges.begin(); it != this->edges.end();) {
+					Component* from = it->first;
+					outputs.clear();
+
+					for(; it != this->edges.end() && it->first == from; ++it)
+						outputs.push_back(it->second);
+
+					dropDuplicates(outputs);
+
+					from->addOutput(outputs.begin(), outputs.end());
+					count += outputs.size();
+				}
+
+				this->edges.clear();
+
+				return count;
+			}
+	};
+}
+
+#endif // SYNCHROTRONTOPOLOGY_HPP
@@ -0,0 +1,284 @@
+#ifndef SYNCHROTRONTRACE_HPP
+#define SYNCHROTRONTRACE_HPP
+
+/**
+ *	State transition trace, only compiled in when SYNCHROTRON_TRACE is defined (e.g. -DSYNCHROTRON_TRACE).
+ *	Otherwise SYNCHROTRON_TRACE_CHANGE expands to a no-op and its arguments aren't evaluated.
+ *
+ *	*	SYNCHROTRON_TRACE_CHANGE(id, before, after)		Records that the state of Component id went from before to after, if they differ.
+ *														Only the low 64 bits of each state are kept, plus a hash of the full state,
+ *														so wider states that only differ above them still show as different.
+ *
+ *	SYNCHROTRON_TRACE_SIZE sets the amount of transitions kept per thread (a power of 2, 1024 by default).
+ */
+#ifdef SYNCHROTRON_TRACE
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#ifndef SYNCHROTRON_TRACE_SIZE
+	#define SYNCHROTRON_TRACE_SIZE 1024
+#endif
+
+namespace Synchrotron {
+namespace Trace {
+
+	static_assert((SYNCHROTRON_TRACE_SIZE & (SYNCHROTRON_TRACE_SIZE - 1)) == 0, "SYNCHROTRON_TRACE_SIZE must be a power of 2");
+
+	/** \brief
+	 *	A state transition. Only the low 64 bits of wider states are kept, next to a hash of the full state.
+	 */
+	struct Event {
+		uint64_t	time;			///< Nanoseconds on the steady clock.
+		uint64_t	sequence;		///< Counts the transitions of the thread that made it, from 1.
+		size_t		thread;			///< The index of that thread's Ring.
+		size_t		id;
+		uint64_t	before;
+		uint64_t	after;
+		size_t		beforeHash;
+		size_t		afterHash;
+	};
+
+	/** \brief
+	 *	Ring keeps the last SYNCHROTRON_TRACE_SIZE transitions of one thread.
+	 *
+	 *	Only the owning thread writes, without locks or read-modify-writes, and numbers its own events. Every entry is a seqlock:
+	 *	its sequence is 0 while it is written, so a reader on another thread drops entries that changed under it
+	 *	instead of waiting for the writer.
+	 */
+	class Ring {
+		private:
+			struct Entry {
+				std::atomic<uint64_t>	sequence;
+				std::atomic<uint64_t>	time;
+				std::atomic<size_t>		id;
+				std::atomic<uint64_t>	before;
+				std::atomic<uint64_t>	after;
+				std::atomic<size_t>		beforeHash;
+				std::atomic<size_t>		afterHash;
+			};
+
+			Entry		entries[SYNCHROTRON_TRACE_SIZE];
+			uint64_t	next;
+
+		public:
+			Ring() : next(0) {
+				for(auto& e : this->entries) e.sequence = 0;
+			}
+
+			/**	\brief	Writes an event over the oldest one, from the owning thread only.
+			 *
+			 *		Numbered by the Ring itself, so threads never share a counter.
+			 */
+			void push(uint64_t time, size_t id, uint64_t before, uint64_t after, size_t beforeHash, size_t afterHash) {
+				const uint64_t sequence = ++this->next;
+				Entry& e = this->entries[(sequence - 1) & (SYNCHROTRON_TRACE_SIZE - 1)];
+
+				e.sequence.store(0, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+
+				e.time.store(time, std::memory_order_relaxed);
+				e.id.store(id, std::memory_order_relaxed);
+				e.before.store(before, std::memory_order_relaxed);
+				e.after.store(after, std::memory_order_relaxed);
+				e.beforeHash.store(beforeHash, std::memory_order_relaxed);
+				e.afterHash.store(afterHash, std::memory_order_relaxed);
+
+				e.sequence.store(sequence, std::memory_order_release);
+			}
+
+			/**	\brief	Appends every complete event to events, from any thread, while the owner keeps writing.
+			 *
+			 *	\param	thread
+			 *		The index of this Ring, stored in every Event.
+			 */
+			void read(std::vector<Event>& events, size_t thread) const {
+				for(auto& e : this->entries) {
+					Event event;
+					event.sequence = e.sequence.load(std::memory_order_acquire);
+
+					if (event.sequence == 0)
+						continue;
+
+					event.time		 = e.time.load(std::memory_order_relaxed);
+					event.thread	 = thread;
+					event.id		 = e.id.load(std::memory_order_relaxed);
+					event.before	 = e.before.load(std::memory_order_relaxed);
+					event.after		 = e.after.load(std::memory_order_relaxed);
+					event.beforeHash = e.beforeHash.load(std::memory_order_relaxed);
+					event.afterHash	 = e.afterHash.load(std::memory_order_relaxed);
+
+					std::atomic_thread_fence(std::memory_order_acquire);
+
+					if (e.sequence.load(std::memory_order_relaxed) == event.sequence)
+						events.push_back(event);
+				}
+			}
+	};
+
+	/** \brief
+	 *	Registry hands out a Ring per thread, like the EpochManager hands out its Records.
+	 *
+	 *	A thread claims a Ring on first use and releases it when it exits, the next thread continues writing in it,
+	 *	so the last transitions of exited threads can still be read. Rings are allocated once and never freed.
+	 *	Threads beyond MAX_THREADS aren't traced, see getDropped().
+	 */
+	class Registry {
+		public:
+			static const size_t MAX_THREADS = 256;
+
+		private:
+			struct Slot {
+				std::atomic<Ring*>	ring;
+				std::atomic<bool>	claimed;
+			};
+
+			Slot					slots[MAX_THREADS];
+			std::atomic<uint64_t>	m_dropped;
+
+			/**	\brief
+			 *	Claims a Ring for the current thread, and releases it when the thread exits.
+			 */
+			struct ThreadSlot {
+				Slot* slot;
+
+				ThreadSlot() : slot(nullptr) {
+					for(auto& s : Registry::instance().slots) {
+						bool expected = false;
+						if (s.claimed.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+							if (!s.ring.load(std::memory_order_relaxed))
+								s.ring.store(new Ring(), std::memory_order_release);
+
+							this->slot = &s;
+							return;
+						}
+					}
+				}
+
+				~ThreadSlot() {
+					if (this->slot)
+						this->slot->claimed.store(false, std::memory_order_release);
+				}
+			};
+
+			Registry() : m_dropped(0) {
+				for(auto& s : this->slots) {
+					s.ring	  = nullptr;
+					s.claimed = false;
+				}
+			}
+
+		public:
+			static Registry& instance() {
+				static Registry registry;
+				return registry;
+			}
+
+			/**	\brief	Gets the Ring of the calling thread, null if it has none.
+			 */
+			static Ring* local() {
+				static thread_local ThreadSlot slot;
+				return slot.slot ? slot.slot->ring.load(std::memory_order_relaxed) : nullptr;
+			}
+
+			inline void drop() {
+				this->m_dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			/**	\brief	Gets the amount of events of untraced threads.
+			 */
+			inline uint64_t getDropped() const {
+				return this->m_dropped.load(std::memory_order_relaxed);
+			}
+
+			/**	\brief	Calls f(ring, index) for every Ring that was handed out.
+			 */
+			template <class F>
+			void forEach(F f) const {
+				for(size_t i = 0; i < MAX_THREADS; i++) {
+					if (const Ring* ring = this->slots[i].ring.load(std::memory_order_acquire))
+						f(*ring, i);
+				}
+			}
+	};
+
+	/**	\brief	Gets the low 64 bits of a state.
+	 */
+	template <size_t N>
+	inline uint64_t lowBits(const std::bitset<N>& bits) {
+		return (bits & std::bitset<N>(~0ull)).to_ullong();
+	}
+
+	/**	\brief	Gets the time of an event, in nanoseconds on the steady clock.
+	 */
+	inline uint64_t now() {
+		return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/**	\brief	Records a transition of Component id on the calling thread's Ring.
+	 */
+	template <size_t N>
+	void record(size_t id, const std::bitset<N>& before, const std::bitset<N>& after) {
+		Ring* ring = Registry::local();
+
+		if (!ring) {
+			Registry::instance().drop();
+			return;
+		}
+
+		std::hash<std::bitset<N>> hash;
+		ring->push(now(), id, lowBits(before), lowBits(after), hash(before), hash(after));
+	}
+
+	/**	\brief	Gets the traced transitions of every thread, oldest first, while they keep being traced.
+	 *
+	 *		The threads are merged by time, then by thread and sequence, so the events of one thread keep their order
+	 *		even if the clock didn't advance between them. Events of different threads closer than the clock's resolution
+	 *		may not be in the order they happened.
+	 *
+	 *		Each thread keeps its last SYNCHROTRON_TRACE_SIZE transitions, so the oldest events of a busy thread
+	 *		may already be overwritten while those of a quiet one are still there.
+	 */
+	inline std::vector<Event> collect() {
+		std::vector<Event> events;
+
+		Registry::instance().forEach([&](const Ring& ring, size_t thread) { ring.read(events, thread); });
+
+		std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+			if (a.time != b.time) return a.time < b.time;
+			if (a.thread != b.thread) return a.thread < b.thread;
+			return a.sequence < b.sequence;
+		});
+
+		return events;
+	}
+
+	/**	\brief	Prints collect(), one transition per line.
+	 */
+	inline void dump(FILE* out = stdout) {
+		for(const Event& e : collect()) {
+			fprintf(out, "%20llu  thread %3zu #%-10llu  component %8zu  %016llx -> %016llx  (hash %016llx -> %016llx)\n",
+					(unsigned long long) e.time, e.thread, (unsigned long long) e.sequence, e.id,
+					(unsigned long long) e.before, (unsigned long long) e.after,
+					(unsigned long long) e.beforeHash, (unsigned long long) e.afterHash);
+		}
+	}
+}
+}
+
+#define SYNCHROTRON_TRACE_CHANGE(id, before, after)		do { if ((before) != (after)) Synchrotron::Trace::record((id), (before), (after)); } while (0)
+
+#else
+
+#define SYNCHROTRON_TRACE_CHANGE(id, before, after)		((void) 0)
+
+#endif // SYNCHROTRON_TRACE
+
+#endif // SYNCHROTRONTRACE_HPP
@@ -0,0 +1,894 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "SynchrotronBenchmark.hpp"
+#include "SynchrotronClocked.hpp"
+#include "SynchrotronCompiled.hpp"
+#include "SynchrotronComponent.hpp"
+#include "SynchrotronComponentFList.hpp"
+#include "SynchrotronComponentFlatHash.hpp"
+#include "SynchrotronComponentList.hpp"
+#include "SynchrotronComponentRcu.hpp"
+#include "SynchrotronComponentSetInsertEnd.hpp"
+#include "SynchrotronComponentSetSort.hpp"
+#include "SynchrotronComponentSmallSet.hpp"
+#include "SynchrotronComponentStatic.hpp"
+#include "SynchrotronComponentVector.hpp"
+#include "SynchrotronGenerators.hpp"
+#include "SynchrotronInbox.hpp"
+#include "SynchrotronNetlist.hpp"
+#include "SynchrotronParallelScheduler.hpp"
+#include "SynchrotronScheduler.hpp"
+#include "SynchrotronThreadPool.hpp"
+#include "SynchrotronTopology.hpp"
+
+/*
+ *	Benchmarks for the SynchrotronComponent variants and engines.
+ *	Run without arguments to run every benchmark, or pass the names of the ones to run,
+ *	see Benchmark::Options for the other options.
+ */
+
+#define CHAINS		10
+#define DEPTH		1000
+#define TIMES		(suite->getOptions().repetitions)
+#define GATES		10000
+
+using namespace Synchrotron;
+
+/*
+ *	Count every heap allocation, to report allocations per connection.
+ *	New and delete aren't inlined, so GCC doesn't flag free() on memory from (what it takes for) the builtin new.
+ */
+static std::atomic<size_t> allocations(0);
+
+__attribute__((noinline)) void* operator new(size_t size) {
+	++allocations;
+	if (void* p = malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+	free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept {
+	free(p);
+}
+
+static Benchmark::Suite* suite = nullptr;
+
+void printResults(const char* name, const std::vector<uint64_t>& v) {
+	suite->record(name, "", 0, v);
+}
+
+template <class S, class F>
+std::vector<uint64_t> measure(size_t times, S setup, F f) {
+	return suite->run(times, setup, f);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Every variant: addOutput(range), emit() and removeOutput() of 10^2 to 10^7 outputs
+////////////////////////////////////////////////////////////////////////////////
+template <class SYNCHROTRON>
+void benchmarkVariant(const char* name, bool linearRemove) {
+	const Benchmark::Options& options = suite->getOptions();
+
+	for (size_t elements : suite->sizes(linearRemove)) {
+		SYNCHROTRON									signalprovider(0x8000);
+		std::vector<std::unique_ptr<SYNCHROTRON>>	owned;
+		std::vector<SYNCHROTRON*>					slots;
+		std::vector<uint64_t>						add, emit, remove;
+
+		for (size_t i = 0; i < elements; i++) {
+			owned.emplace_back(new SYNCHROTRON(i % 0xFFFF));
+			slots.push_back(owned.back().get());
+		}
+
+		for (size_t i = 0; i < options.warmup + TIMES; i++) {
+			const uint64_t t1 = Benchmark::now();
+			signalprovider.addOutput(slots.begin(), slots.end());
+			const uint64_t t2 = Benchmark::now();
+			signalprovider.emit();
+			const uint64_t t3 = Benchmark::now();
+
+			for (auto s : slots)
+				signalprovider.removeOutput(*s);
+
+			const uint64_t t4 = Benchmark::now();
+
+			if (i < options.warmup)
+				continue;
+
+			add.push_back(t2 - t1);
+			emit.push_back(t3 - t2);
+			remove.push_back(t4 - t3);
+		}
+
+		suite->record("addOutput", name, elements, add);
+		suite->record("emit", name, elements, emit);
+		suite->record("removeOutput", name, elements, remove);
+	}
+}
+
+void benchmarkVariants() {
+	std::cout << "Connect, emit to and disconnect outputs, every variant:" << std::endl;
+	benchmarkVariant<SynchrotronComponent<16>>("Component<16>", false);
+	benchmarkVariant<SynchrotronComponentList<16>>("List<16>", true);
+	benchmarkVariant<SynchrotronComponentFList<16>>("FList<16>", true);
+	benchmarkVariant<SynchrotronComponentVector<16>>("Vector<16>", true);
+	benchmarkVariant<SynchrotronComponentSetInsertEnd<16>>("SetInsertEnd<16>", false);
+	benchmarkVariant<SynchrotronComponentSetSort<16>>("SetSort<16>", false);
+	benchmarkVariant<SynchrotronComponentSmallSet<16>>("SmallSet<16>", true);
+	benchmarkVariant<SynchrotronComponentFlatHash<16>>("FlatHash<16>", false);
+	benchmarkVariant<SynchrotronComponentRcu<16>>("Rcu<16>", true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Virtual vs CRTP: emit() through CHAINS chains of DEPTH Components
+////////////////////////////////////////////////////////////////////////////////
+template <class SYNCHROTRON>
+void benchmarkChainEmit(const char* name) {
+	SYNCHROTRON								signalprovider;
+	std::vector<std::unique_ptr<SYNCHROTRON>>	slots;
+
+	for (int c = 0; c < CHAINS; c++) {
+		SYNCHROTRON* prev = &signalprovider;
+
+		for (int d = 0; d < DEPTH; d++) {
+			slots.emplace_back(new SYNCHROTRON());
+			prev->addOutput(*slots.back());
+			prev = slots.back().get();
+		}
+	}
+
+	auto runtimes = measure(TIMES, [&](size_t i) {
+		signalprovider.setState(i + 1);
+		for(auto& s : slots) s->setState(0);
+	}, [&](size_t) {
+		signalprovider.emit();
+	});
+
+	// Release in reverse, so every destructor only has to disconnect its predecessor
+	while (!slots.empty()) slots.pop_back();
+
+	printResults(name, runtimes);
+}
+
+void benchmarkDevirtualized() {
+	std::cout << "Emit through " << CHAINS << " chains of " << DEPTH << " Components:" << std::endl;
+	benchmarkChainEmit<SynchrotronComponentSetSort<16>>("virtual  SetSort<16>");
+	benchmarkChainEmit<SynchrotronComponentStatic<16>>("CRTP     Static<16>");
+	benchmarkChainEmit<SynchrotronComponentStatic<16, OrPolicy, StdMutexLock>>("CRTP     Static<16, StdMutexLock>");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Adjacency storage: GATES gates with 1-3 random earlier gates as input
+////////////////////////////////////////////////////////////////////////////////
+template <class SYNCHROTRON>
+void benchmarkGateAdjacency(const char* name) {
+	std::vector<std::unique_ptr<SYNCHROTRON>>	gates;
+	std::mt19937								random(42);
+	size_t										edges = 0;
+
+	for (int i = 0; i < GATES; i++)
+		gates.emplace_back(new SYNCHROTRON(i % 0xFFFF));
+
+	const size_t before = allocations;
+	auto t1 = std::chrono::high_resolution_clock::now();
+
+	for (size_t i = 1; i < gates.size(); i++) {
+		const size_t fanin = 1 + random() % 3;
+
+		for (size_t k = 0; k < fanin; k++, edges++)
+			gates[i]->addInput(*gates[random() % i]);
+	}
+
+	auto t2 = std::chrono::high_resolution_clock::now();
+	const size_t allocated = allocations - before;
+
+	auto runtimes = measure(TIMES, [&](size_t i) {
+		for(auto& g : gates) g->setState(0);
+		gates[0]->setState(i + 1);
+	}, [&](size_t) {
+		gates[0]->emit();
+	});
+
+	printf("%-44s :: Allocations per connection: %5.2f :: Connect time: %10zu ns\n", name,
+		   double(allocated) / edges, size_t(std::chrono::duration_cast<std::chrono::nanoseconds>(t2-t1).count()));
+	printResults(name, runtimes);
+}
+
+void benchmarkAdjacency() {
+	std::cout << "Adjacency of " << GATES << " gates with a fan-in of 1-3:" << std::endl;
+	benchmarkGateAdjacency<SynchrotronComponentSetSort<16>>("std::set  SetSort<16>");
+	benchmarkGateAdjacency<SynchrotronComponentSmallSet<16>>("inline    SmallSet<16>");
+	benchmarkGateAdjacency<SynchrotronComponentSmallSet<16, OrPolicy, StdMutexLock, 8>>("inline    SmallSet<16, ..., 8>");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Build and tear down GATES gates with 1-3 random earlier gates as input
+////////////////////////////////////////////////////////////////////////////////
+template <class GATES_VECTOR>
+void buildGates(GATES_VECTOR& gates, std::mt19937& random) {
+	for (size_t i = 1; i < gates.size(); i++) {
+		const size_t fanin = 1 + random() % 3;
+
+		for (size_t k = 0; k < fanin; k++)
+			gates[i]->addInput(*gates[random() % i]);
+	}
+}
+
+template <class SYNCHROTRON>
+void benchmarkHeapRebuild(const char* name) {
+	size_t allocated = 0;
+
+	auto runtimes = measure(TIMES, [](size_t) {}, [&](size_t) {
+		std::vector<std::unique_ptr<SYNCHROTRON>>	gates;
+		std::mt19937								random(42);
+		const size_t								before = allocations;
+
+		for (int i = 0; i < GATES; i++)
+			gates.emplace_back(new SYNCHROTRON(i % 0xFFFF));
+
+		buildGates(gates, random);
+
+		// Release in reverse, like Netlist::clear()
+		while (!gates.empty()) gates.pop_back();
+
+		allocated = allocations - before;
+	});
+
+	printf("%-44s :: Allocations per rebuild: %8zu\n", name, allocated);
+	printResults(name, runtimes);
+}
+
+template <class SYNCHROTRON>
+void benchmarkArenaRebuild(const char* name) {
+	Netlist<SYNCHROTRON>	netlist;
+	size_t					allocated = 0;
+
+	auto runtimes = measure(TIMES, [](size_t) {}, [&](size_t) {
+		std::vector<SYNCHROTRON*>	gates;
+		std::mt19937				random(42);
+		const size_t				before = allocations;
+
+		for (int i = 0; i < GATES; i++)
+			gates.push_back(&netlist.create(i % 0xFFFF));
+
+		buildGates(gates, random);
+		netlist.clear();
+
+		allocated = allocations - before;
+	});
+
+	printf("%-44s :: Allocations per rebuild: %8zu\n", name, allocated);
+	printResults(name, runtimes);
+}
+
+void benchmarkArena() {
+	std::cout << "Build and tear down " << GATES << " gates with a fan-in of 1-3:" << std::endl;
+	benchmarkHeapRebuild<SynchrotronComponentSetSort<16>>("new/delete SetSort<16>");
+	benchmarkArenaRebuild<SynchrotronComponentSetSort<16, OrPolicy, StdMutexLock, ArenaAllocator<void*>>>("Netlist    SetSort<16, ..., Arena>");
+	benchmarkHeapRebuild<SynchrotronComponentSmallSet<16>>("new/delete SmallSet<16>");
+	benchmarkArenaRebuild<SynchrotronComponentSmallSet<16, OrPolicy, StdMutexLock, 4, ArenaAllocator<void*>>>("Netlist    SmallSet<16, ..., Arena>");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Tear down GATES * 10 gates with 1-3 random earlier gates as input
+////////////////////////////////////////////////////////////////////////////////
+template <class SYNCHROTRON>
+void benchmarkTeardown(const char* heapName, const char* netlistName) {
+	std::vector<std::unique_ptr<SYNCHROTRON>>	gates;
+	Netlist<SYNCHROTRON>						netlist;
+
+	auto runtimes = measure(TIMES, [&](size_t) {
+		std::mt19937 random(42);
+
+		for (int i = 0; i < GATES * 10; i++)
+			gates.emplace_back(new SYNCHROTRON(i % 0xFFFF));
+
+		buildGates(gates, random);
+	}, [&](size_t) {
+		while (!gates.empty()) gates.pop_back();
+	});
+
+	printResults(heapName, runtimes);
+
+	runtimes = measure(TIMES, [&](size_t) {
+		std::vector<SYNCHROTRON*>	created;
+		std::mt19937				random(42);
+
+		for (int i = 0; i < GATES * 10; i++)
+			created.push_back(&netlist.create(i % 0xFFFF));
+
+		buildGates(created, random);
+	}, [&](size_t) {
+		netlist.clear();
+	});
+
+	printResults(netlistName, runtimes);
+}
+
+void benchmarkTeardownAll() {
+	std::cout << "Tear down " << GATES * 10 << " gates with a fan-in of 1-3:" << std::endl;
+	benchmarkTeardown<SynchrotronComponentSetSort<16>>("per edge   SetSort<16>", "Netlist    SetSort<16>");
+	benchmarkTeardown<SynchrotronComponentSetSort<16, OrPolicy, StdMutexLock, ArenaAllocator<void*>>>(
+		"per edge   SetSort<16, ..., Arena>", "Netlist    SetSort<16, ..., Arena>");
+	benchmarkTeardown<SynchrotronComponentFlatHash<16>>("per edge   FlatHash<16>", "Netlist    FlatHash<16>");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Topology: connect GATES outputs to one Component, one by one vs in a batch
+////////////////////////////////////////////////////////////////////////////////
+template <class SYNCHROTRON>
+void benchmarkFanOut(const char* name) {
+	SYNCHROTRON									signalprovider(0x8000);
+	std::vector<std::unique_ptr<SYNCHROTRON>>	owned;
+	std::vector<SYNCHROTRON*>					slots;
+
+	for (int i = 0; i < GATES; i++) {
+		owned.emplace_back(new SYNCHROTRON(i % 0xFFFF));
+		slots.push_back(owned.back().get());
+	}
+
+	// Like a netlist loaded from a file, the outputs aren't in order of creation
+	std::shuffle(slots.begin(), slots.end(), std::mt19937(42));
+
+	auto disconnect = [&](size_t) {
+		for(auto s : slots) signalprovider.removeOutput(*s);
+	};
+
+	std::string label(name);
+
+	auto runtimes = measure(TIMES, disconnect, [&](size_t) {
+		for(auto s : slots) signalprovider.addOutput(*s);
+	});
+	printResults((label + " one by one").c_str(), runtimes);
+
+	runtimes = measure(TIMES, disconnect, [&](size_t) {
+		signalprovider.addOutput(slots.begin(), slots.end());
+	});
+	printResults((label + " range").c_str(), runtimes);
+
+	runtimes = measure(TIMES, disconnect, [&](size_t) {
+		TopologyBuilder<SYNCHROTRON> builder;
+		builder.fanOut(signalprovider, slots.begin(), slots.end());
+		builder.commit();
+	});
+	printResults((label + " builder").c_str(), runtimes);
+
+	disconnect(0);
+}
+
+void benchmarkTopology() {
+	std::cout << "Connect " << GATES << " outputs to one Component:" << std::endl;
+	benchmarkFanOut<SynchrotronComponentSetSort<16>>("SetSort<16>");
+	benchmarkFanOut<SynchrotronComponentSmallSet<16>>("SmallSet<16>");
+	benchmarkFanOut<SynchrotronComponentFlatHash<16>>("FlatHash<16>");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Concurrent topology edits: threads connect and disconnect random pairs of GATES Components
+////////////////////////////////////////////////////////////////////////////////
+template <class SYNCHROTRON>
+void benchmarkConcurrentEdits(const char* name) {
+	const size_t edits = GATES * 5;
+	std::vector<std::unique_ptr<SYNCHROTRON>> gates;
+
+	for (int i = 0; i < GATES; i++)
+		gates.emplace_back(new SYNCHROTRON(i % 0xFFFF));
+
+	for (size_t threads = 1; threads <= 32; threads *= 2) {
+		std::vector<std::thread> workers;
+
+		auto t1 = std::chrono::high_resolution_clock::now();
+
+		for (size_t t = 0; t < threads; t++) {
+			workers.emplace_back([&, t]() {
+				std::mt19937 random(t);
+				std::vector<std::pair<SYNCHROTRON*, SYNCHROTRON*>> added;
+
+				for (size_t i = 0; i < edits / threads; i++) {
+					SYNCHROTRON* from = gates[random() % GATES].get();
+					SYNCHROTRON* to   = gates[random() % GATES].get();
+
+					from->addOutput(*to);
+					added.emplace_back(from, to);
+				}
+
+				for (auto& edge : added)
+					edge.second->removeInput(*edge.first);
+			});
+		}
+
+		for (auto& worker : workers) worker.join();
+
+		auto t2 = std::chrono::high_resolution_clock::now();
+		const double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(t2-t1).count() / 1e9;
+
+		printf("%-44s :: %2zu threads :: %12.0f edges/s\n", name, threads, 2 * (edits / threads) * threads / seconds);
+	}
+}
+
+void benchmarkConcurrency() {
+	std::cout << "Connect and disconnect " << GATES * 5 << " random pairs of " << GATES << " Components:" << std::endl;
+	benchmarkConcurrentEdits<SynchrotronComponentSetSort<16, OrPolicy, StdMutexLock>>("SetSort<16, ..., StdMutexLock>");
+	benchmarkConcurrentEdits<SynchrotronComponentSetSort<16, OrPolicy, SpinLock>>("SetSort<16, ..., SpinLock>");
+	benchmarkConcurrentEdits<SynchrotronComponentFlatHash<16, OrPolicy, SpinLock>>("FlatHash<16, ..., SpinLock>");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Epoch grace period: readers emit() while a writer swaps outputs and waits for the grace period
+////////////////////////////////////////////////////////////////////////////////
+void benchmarkEpoch() {
+	typedef SynchrotronComponentRcu<16, OrPolicy, SpinLock> SYNCHROTRON;
+
+	std::cout << "Readers emit() to " << DEPTH << " outputs while a writer swaps one of them:" << std::endl;
+
+	for (size_t readers = 1; readers <= 8; readers *= 2) {
+		SYNCHROTRON									source(1);
+		std::vector<std::unique_ptr<SYNCHROTRON>>	outputs;
+		std::atomic<bool>							stop(false);
+		std::atomic<size_t>							emits(0);
+		std::atomic<size_t>							started(0);
+		std::vector<std::thread>					workers;
+
+		for (int i = 0; i < DEPTH; i++) {
+			outputs.emplace_back(new SYNCHROTRON());
+			source.addOutput(*outputs.back());
+		}
+
+		for (size_t t = 0; t < readers; t++) {
+			workers.emplace_back([&]() {
+				++started;
+
+				while (!stop) {
+					source.emit();
+					++emits;
+				}
+			});
+		}
+
+		// Otherwise the first grace periods are waited for without any reader
+		while (started < readers)
+			std::this_thread::yield();
+
+		std::vector<uint64_t> grace;
+		auto t1 = std::chrono::high_resolution_clock::now();
+
+		for (size_t i = 0; i < TIMES; i++) {
+			SYNCHROTRON probe;
+			source.addOutput(probe);
+			source.removeOutput(probe);
+
+			auto g1 = std::chrono::high_resolution_clock::now();
+			EpochManager::instance().synchronize();
+			auto g2 = std::chrono::high_resolution_clock::now();
+			grace.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(g2-g1).count());
+		}
+
+		auto t2 = std::chrono::high_resolution_clock::now();
+		stop = true;
+		for (auto& worker : workers) worker.join();
+
+		const double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(t2-t1).count() / 1e9;
+		char name[64];
+		snprintf(name, sizeof(name), "grace period, %zu readers", readers);
+
+		printResults(name, grace);
+		printf("%-44s :: %12.0f emits/s\n", name, emits / seconds);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Parallel levelized evaluation: levels of GATES Components, evaluated on 1 to 64 threads
+////////////////////////////////////////////////////////////////////////////////
+#define LEVELS		16
+#define FAN_IN		4
+
+template <class SYNCHROTRON>
+void buildLevels(Netlist<SYNCHROTRON>& netlist, std::mt19937& random) {
+	std::vector<SYNCHROTRON*> layer, next;
+
+	for (int i = 0; i < GATES; i++)
+		layer.push_back(&netlist.create(random() % 0xFFFF));
+
+	for (int l = 1; l < LEVELS; l++) {
+		next.clear();
+
+		for (int i = 0; i < GATES; i++) {
+			next.push_back(&netlist.create());
+
+			for (int j = 0; j < FAN_IN; j++)
+				layer[random() % GATES]->addOutput(*next.back());
+		}
+
+		layer.swap(next);
+	}
+}
+
+void benchmarkParallel() {
+	typedef SynchrotronComponentSetSort<16> SYNCHROTRON;
+
+	const size_t levels = LEVELS, fanIn = FAN_IN;
+	Netlist<SYNCHROTRON> netlist;
+	std::mt19937 random(0);
+
+	buildLevels(netlist, random);
+
+	CompiledNetlist<SYNCHROTRON> compiled(netlist.getComponents().begin(), netlist.getComponents().end());
+
+	std::cout << "Evaluate " << levels << " levels of " << GATES << " Components with " << fanIn << " inputs each:" << std::endl;
+
+	double single = 0;
+
+	for (size_t threads = 1; threads <= 64; threads *= 2) {
+		ThreadPool pool(threads);
+
+		auto runtimes = measure(TIMES, [](size_t) {}, [&](size_t) { compiled.evaluate(pool); });
+		std::sort(runtimes.begin(), runtimes.end());
+
+		const double median = Benchmark::Stats::of(runtimes).median;
+		if (threads == 1) single = median;
+
+		char name[64];
+		snprintf(name, sizeof(name), "evaluate(pool), %zu threads", threads);
+
+		printResults(name, runtimes);
+		printf("%-44s :: speedup %5.2fx\n", name, single / median);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Sparse activity: a few sources of LEVELS levels of GATES Components change, event-driven on 1 to 64 threads
+////////////////////////////////////////////////////////////////////////////////
+void benchmarkParallelScheduler() {
+	typedef SynchrotronComponentSetSort<16> SYNCHROTRON;
+
+	const size_t active = 16;
+	Netlist<SYNCHROTRON> netlist;
+	std::mt19937 random(0);
+
+	buildLevels(netlist, random);
+
+	const std::vector<SYNCHROTRON*>& gates = netlist.getComponents();
+
+	// Every run starts from cleared states, with `active` random sources set
+	auto setup = [&](size_t i) {
+		std::mt19937 sources(i);
+
+		for (auto gate : gates)
+			gate->setState(0);
+
+		for (size_t j = 0; j < active; j++)
+			gates[sources() % GATES]->setState(1 << (j % 16));
+	};
+
+	auto emitSources = [&](size_t i, std::function<void(SYNCHROTRON&)> emit) {
+		std::mt19937 sources(i);
+
+		for (size_t j = 0; j < active; j++)
+			emit(*gates[sources() % GATES]);
+	};
+
+	std::cout << "Propagate " << active << " changed sources through " << LEVELS << " levels of " << GATES << " Components:" << std::endl;
+
+	Scheduler<SYNCHROTRON> scheduler;
+	auto serial = measure(TIMES, setup, [&](size_t i) {
+		emitSources(i, [&](SYNCHROTRON& source) { scheduler.emit(source); });
+		scheduler.run();
+	});
+
+	std::sort(serial.begin(), serial.end());
+	printResults("Scheduler", serial);
+
+	for (size_t threads = 1; threads <= 64; threads *= 2) {
+		ThreadPool pool(threads);
+		ParallelScheduler<SYNCHROTRON> parallel(pool);
+
+		auto runtimes = measure(TIMES, setup, [&](size_t i) {
+			emitSources(i, [&](SYNCHROTRON& source) { parallel.emit(source); });
+			parallel.run();
+		});
+
+		std::sort(runtimes.begin(), runtimes.end());
+
+		char name[64];
+		snprintf(name, sizeof(name), "ParallelScheduler, %zu threads", threads);
+
+		printResults(name, runtimes);
+		printf("%-44s :: speedup %5.2fx\n", name, (double) Benchmark::Stats::of(serial).median / Benchmark::Stats::of(runtimes).median);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Shared consumer: producer threads emit into one Component, through its mutex or its inbox
+////////////////////////////////////////////////////////////////////////////////
+void benchmarkInbox() {
+	typedef SynchrotronComponentSetSort<16> SYNCHROTRON;
+
+	const size_t emits = GATES * 20;
+
+	std::cout << "Producers emit " << emits << " times in total into one consumer:" << std::endl;
+
+	for (size_t producers = 2; producers <= 32; producers *= 2) {
+		std::vector<std::unique_ptr<SYNCHROTRON>> sources;
+
+		for (size_t p = 0; p < producers; p++)
+			sources.emplace_back(new SYNCHROTRON());
+
+		// Every producer takes the consumer's mutex around its tick
+		{
+			SYNCHROTRON consumer;
+			std::vector<std::thread> workers;
+
+			for (auto& source : sources) source->addOutput(consumer);
+
+			auto t1 = std::chrono::high_resolution_clock::now();
+
+			for (size_t p = 0; p < producers; p++) {
+				workers.emplace_back([&, p]() {
+					SYNCHROTRON& source = *sources[p];
+
+					for (size_t i = 0; i < emits / producers; i++) {
+						source.setState(1 << (i % 16));
+						consumer.lock();
+						source.emit();
+						consumer.unlock();
+					}
+				});
+			}
+
+			for (auto& worker : workers) worker.join();
+
+			auto t2 = std::chrono::high_resolution_clock::now();
+			const double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(t2-t1).count() / 1e9;
+
+			printf("%-44s :: %2zu producers :: %12.0f emits/s\n", "locked consumer", producers, emits / seconds);
+
+			for (auto& source : sources) source->removeOutput(consumer);
+		}
+
+		// Every producer pushes to the inbox, the consumer thread drains it
+		{
+			InboxComponent<SYNCHROTRON> consumer;
+			std::vector<std::thread> workers;
+			std::atomic<size_t> running(producers);
+			size_t drained = 0;
+
+			for (auto& source : sources) source->addOutput(consumer);
+
+			auto t1 = std::chrono::high_resolution_clock::now();
+
+			for (size_t p = 0; p < producers; p++) {
+				workers.emplace_back([&, p]() {
+					SYNCHROTRON& source = *sources[p];
+
+					for (size_t i = 0; i < emits / producers; i++) {
+						source.setState(1 << (i % 16));
+						source.emit();
+					}
+
+					--running;
+				});
+			}
+
+			while (running)
+				drained += consumer.drain();
+
+			for (auto& worker : workers) worker.join();
+			drained += consumer.drain();
+
+			auto t2 = std::chrono::high_resolution_clock::now();
+			const double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(t2-t1).count() / 1e9;
+
+			printf("%-44s :: %2zu producers :: %12.0f emits/s (%zu drained)\n", "InboxComponent", producers, emits / seconds, drained);
+
+			for (auto& source : sources) source->removeOutput(consumer);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Snapshot of every state: through the Components vs the contiguous StateArray of the Netlist
+////////////////////////////////////////////////////////////////////////////////
+void benchmarkStates() {
+	typedef SynchrotronComponentSetSort<16, OrPolicy, StdMutexLock, std::allocator<void*>, ExternalState> SYNCHROTRON;
+
+	Netlist<SYNCHROTRON> netlist;
+	std::mt19937 random(0);
+	std::vector<Netlist<SYNCHROTRON>::state_type> snapshot;
+
+	buildLevels(netlist, random);
+
+	std::cout << "Snapshot the states of " << netlist.size() << " Components:" << std::endl;
+
+	auto components = measure(TIMES, [&](size_t) { snapshot.clear(); }, [&](size_t) {
+		for (auto c : netlist.getComponents())
+			snapshot.push_back(c->getState());
+	});
+	printResults("getState() per Component", components);
+
+	auto contiguous = measure(TIMES, [&](size_t) { snapshot.clear(); }, [&](size_t) {
+		netlist.getStates().snapshot(snapshot);
+	});
+	printResults("StateArray::snapshot()", contiguous);
+
+	auto diff = measure(TIMES, [](size_t) {}, [&](size_t) {
+		if (netlist.getStates().diff(snapshot)) abort();
+	});
+	printResults("StateArray::diff()", diff);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Wide fan-in: reduce 64 inputs of N bits, copying every input vs the SIMD word kernels
+////////////////////////////////////////////////////////////////////////////////
+template <size_t N>
+void benchmarkWideReduce() {
+	const size_t fanIn = 64;
+	std::vector<std::bitset<N>> inputs(fanIn);
+	std::mt19937 random(N);
+	std::bitset<N> result;
+
+	for (auto& input : inputs) {
+		for (size_t b = 0; b < N; b++)
+			input[b] = random() & 1;
+	}
+
+	auto byValue	 = [](const std::bitset<N>& b) { return b; };
+	auto byReference = [](const std::bitset<N>& b) -> const std::bitset<N>& { return b; };
+
+	char name[64];
+
+	auto copied = measure(TIMES * 10, [](size_t) {}, [&](size_t) {
+		result = XorPolicy::reduce(result, inputs.begin(), inputs.end(), byValue);
+	});
+	snprintf(name, sizeof(name), "%zu bits, getState() copies", N);
+	printResults(name, copied);
+
+	auto kernel = measure(TIMES * 10, [](size_t) {}, [&](size_t) {
+		result = XorPolicy::reduce(result, inputs.begin(), inputs.end(), byReference);
+	});
+	snprintf(name, sizeof(name), "%zu bits, getStateRef() + %s", N, N >= SIMD_MIN_BITS ? Simd::getKernelName() : "fold");
+	printResults(name, kernel);
+
+	if (result.none()) printf("\n");
+}
+
+void benchmarkSimd() {
+	std::cout << "Reduce 64 inputs with XorPolicy:" << std::endl;
+	benchmarkWideReduce<256>();
+	benchmarkWideReduce<512>();
+	benchmarkWideReduce<1024>();
+	benchmarkWideReduce<4096>();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Generated shapes: build, propagate from the first Component, and clock a step
+////////////////////////////////////////////////////////////////////////////////
+template <class SYNCHROTRON, class G>
+void benchmarkShape(const std::string& name, G generate) {
+	Netlist<SYNCHROTRON>								netlist;
+	std::vector<SYNCHROTRON*>							graph;
+	std::vector<typename Netlist<SYNCHROTRON>::state_type>	initial;
+	Scheduler<SYNCHROTRON>								scheduler;
+
+	auto build = measure(TIMES, [&](size_t) { netlist.clear(); }, [&](size_t) { graph = generate(netlist); });
+	suite->record("build", name, graph.size(), build);
+
+	netlist.getStates().snapshot(initial);
+	auto restore = [&](size_t) { netlist.getStates().restore(initial); };
+
+	auto propagate = measure(TIMES, restore, [&](size_t) {
+		scheduler.emit(*graph.front());
+		scheduler.run();
+	});
+	suite->record("propagate", name, graph.size(), propagate);
+
+	ClockedNetlist<SYNCHROTRON> clocked(graph.begin(), graph.end());
+	suite->record("clocked step", name, graph.size(), measure(TIMES, restore, [&](size_t) { clocked.step(); }));
+}
+
+template <class SYNCHROTRON>
+void benchmarkShapes(const std::string& name) {
+	typedef Netlist<SYNCHROTRON> NETLIST;
+
+	benchmarkShape<SYNCHROTRON>(name + " chain", [](NETLIST& n) { return Generators::chain(n, GATES); });
+	benchmarkShape<SYNCHROTRON>(name + " tree", [](NETLIST& n) { return Generators::tree(n, FAN_IN, 6); });
+	benchmarkShape<SYNCHROTRON>(name + " random DAG", [](NETLIST& n) {
+		std::mt19937 random(42);
+		return Generators::randomDag(n, GATES, 2.0 * FAN_IN / GATES, random);
+	});
+	benchmarkShape<SYNCHROTRON>(name + " ring", [](NETLIST& n) { return Generators::ring(n, GATES); });
+	benchmarkShape<SYNCHROTRON>(name + " mesh", [](NETLIST& n) { return Generators::mesh(n, 100, GATES / 100); });
+}
+
+void benchmarkGenerated() {
+	std::cout << "Generated shapes of ~" << GATES << " Components, average fan-in of " << FAN_IN << " in the random DAG:" << std::endl;
+	benchmarkShapes<SynchrotronComponentSetSort<16, OrPolicy, StdMutexLock, ArenaAllocator<void*>, ExternalState>>("SetSort<16, ..., Arena, ExternalState>");
+	benchmarkShapes<SynchrotronComponentFlatHash<16, OrPolicy, StdMutexLock, ArenaAllocator<void*>, ExternalState>>("FlatHash<16, ..., Arena, ExternalState>");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Memory: memoryUsage() of a Netlist with a random DAG of GATES Components, per Component and per connection
+////////////////////////////////////////////////////////////////////////////////
+template <class SYNCHROTRON>
+void benchmarkMemoryUsage(const char* name) {
+	std::mt19937 random(42);
+	Netlist<SYNCHROTRON> unconnected, connected;
+
+	Generators::randomDag(unconnected, GATES, 0, random);
+	std::vector<SYNCHROTRON*> graph = Generators::randomDag(connected, GATES, 2.0 * FAN_IN / GATES, random);
+
+	size_t edges = 0;
+	for (auto c : graph)
+		edges += std::distance(c->getOutputs().begin(), c->getOutputs().end());
+
+	const size_t bytes = connected.memoryUsage();
+
+	printf("%-44s :: %8.1f bytes/Component :: %8.1f bytes/connection :: sizeof %4zu\n", name,
+		   double(unconnected.memoryUsage()) / GATES, double(bytes - unconnected.memoryUsage()) / edges, sizeof(SYNCHROTRON));
+}
+
+void benchmarkMemory() {
+	std::cout << "Memory of a Netlist of " << GATES << " Components, random DAG with an average fan-in of " << FAN_IN << ":" << std::endl;
+	benchmarkMemoryUsage<SynchrotronComponent<16>>("Component<16>");
+	benchmarkMemoryUsage<SynchrotronComponentList<16>>("List<16>");
+	benchmarkMemoryUsage<SynchrotronComponentFList<16>>("FList<16>");
+	benchmarkMemoryUsage<SynchrotronComponentVector<16>>("Vector<16>");
+	benchmarkMemoryUsage<SynchrotronComponentSetInsertEnd<16>>("SetInsertEnd<16>");
+	benchmarkMemoryUsage<SynchrotronComponentSetSort<16>>("SetSort<16>");
+	benchmarkMemoryUsage<SynchrotronComponentSetSort<16, OrPolicy, SpinLock>>("SetSort<16, ..., SpinLock>");
+	benchmarkMemoryUsage<SynchrotronComponentSetSort<16, OrPolicy, StdMutexLock, ArenaAllocator<void*>>>("SetSort<16, ..., Arena>");
+	benchmarkMemoryUsage<SynchrotronComponentSetSort<4096>>("SetSort<4096>");
+	benchmarkMemoryUsage<SynchrotronComponentSetSort<4096, OrPolicy, StdMutexLock, std::allocator<void*>, ExternalState>>("SetSort<4096, ..., ExternalState>");
+	benchmarkMemoryUsage<SynchrotronComponentSmallSet<16>>("SmallSet<16>");
+	benchmarkMemoryUsage<SynchrotronComponentFlatHash<16>>("FlatHash<16>");
+	benchmarkMemoryUsage<SynchrotronComponentRcu<16>>("Rcu<16>");
+}
+
+int main(int argc, char** argv) {
+	Benchmark::Options options;
+
+	if (!options.parse(argc, argv))
+		return 1;
+
+	Benchmark::Suite benchmarks(options);
+	suite = &benchmarks;
+
+	if (suite->selected("variants")) benchmarkVariants();
+	if (suite->selected("devirtualized")) benchmarkDevirtualized();
+	if (suite->selected("adjacency")) benchmarkAdjacency();
+	if (suite->selected("arena")) benchmarkArena();
+	if (suite->selected("teardown")) benchmarkTeardownAll();
+	if (suite->selected("topology")) benchmarkTopology();
+	if (suite->selected("concurrency")) benchmarkConcurrency();
+	if (suite->selected("epoch")) benchmarkEpoch();
+	if (suite->selected("parallel")) benchmarkParallel();
+	if (suite->selected("scheduler")) benchmarkParallelScheduler();
+	if (suite->selected("inbox")) benchmarkInbox();
+	if (suite->selected("states")) benchmarkStates();
+	if (suite->selected("simd")) benchmarkSimd();
+	if (suite->selected("shapes")) benchmarkGenerated();
+	if (suite->selected("memory")) benchmarkMemory();
+
+#ifdef SYNCHROTRON_STATS
+	std::cout << "Counters over every benchmark:" << std::endl;
+	Stats::print(stdout);
+#endif
+
+	return suite->writeJson() ? 0 : 1;
+}
@@ -1,42 +1,19 @@
+#include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
 #include <stdio.h>
+#include <thread>
 #include <vector>
 
 #define BSTR(STRB)	( (STRB) ? "true" : "false" )
 
 /*
- *	Note: signal.emit() with ELEMENTS outputs ~= signal.emit() to slot with ELEMENTS inputs
+ *	Checks every feature on the variant selected with USE_SYNC, printing what it got next to what was expected.
+ *	The performance tests are in benchmark.cpp, see README.md.
  */
-/*	ELEMENTS =   100 000	TIMES =    10
-	std::set<> results: ~more memory usage
-		Test addOutputs    :: Average time:    91 milliseconds :: (min=    78, max=    93)
-		Test emit          :: Average time:     3 milliseconds :: (min=     0, max=    15)
-		Test removeOutputs :: Average time:    84 milliseconds :: (min=    78, max=    94)
-
-	std::forward_list<> results: >>>>time on remove usage
-		Test addOutputs    :: Average time:    78 milliseconds :: (min=    78, max=    78)
-		Test emit          :: Average time:     0 milliseconds :: (min=     0, max=     0)
-		Test removeOutputs :: Average time: 11187 milliseconds :: (min= 11071, max= 11316)
-*/
-/*	ELEMENTS = 1 000 000	TIMES =    10
-	std::set<> results: ~more memory usage
-		Test addOutputs    :: Average time:   938 milliseconds :: (min=   922, max=   969)
-		Test emit 		   :: Average time:    38 milliseconds :: (min=    31, max=    46)
-		Test removeOutputs :: Average time:   848 milliseconds :: (min=   842, max=   860)
-
-	std::forward_list<> results:
-		5+ hours?!
-		==>	std::forward_list<>::remove() is of complexity O(n)
-			whereas std::set<>::erase() uses a LUT with keys generated on insert() and is therefore O(1).
-*/
-/*	ELEMENTS = 1 000		TIMES = 1 000
-		std::set<> results:				Total time: 1638 ms	(others 0 ms)
-		std::forward_list<> results:	Total time: 2449 ms (others 0 ms, except remove: 1 ms)
-*/
-
-//#define TEST_PERFORMANCE
-#define ELEMENTS	10000
-#define TIMES		10
+
 #define USE_SYNC	6
 
 #include "SynchrotronComponent.hpp"				// 1
@@ -45,36 +22,139 @@
 #include "SynchrotronComponentVector.hpp"		// 4
 #include "SynchrotronComponentSetInsertEnd.hpp"	// 5
 #include "SynchrotronComponentSetSort.hpp"		// 6
+#include "SynchrotronComponentSmallSet.hpp"		// 7
+#include "SynchrotronComponentFlatHash.hpp"		// 8
+#include "SynchrotronComponentRcu.hpp"			// 9
+#include "SynchrotronScheduler.hpp"
+#include "SynchrotronCompiled.hpp"
+#include "SynchrotronFrozen.hpp"
+#include "SynchrotronNetlist.hpp"
+#include "SynchrotronTopology.hpp"
+#include "SynchrotronThreadPool.hpp"
+#include "SynchrotronParallelScheduler.hpp"
+#include "SynchrotronInbox.hpp"
+#include "SynchrotronClocked.hpp"
+#include "SynchrotronGenerators.hpp"
 
 using namespace Synchrotron;
 
 #if USE_SYNC == 1
 	typedef SynchrotronComponent<16> SYNCHROTRON;
+	typedef SynchrotronComponent<16, OrPolicy, StdMutexLock, ArenaAllocator<void*>, ExternalState> ARENA_SYNCHROTRON;
 #elif USE_SYNC == 2
 	typedef SynchrotronComponentList<16> SYNCHROTRON;
+	typedef SynchrotronComponentList<16, OrPolicy, StdMutexLock, ArenaAllocator<void*>, ExternalState> ARENA_SYNCHROTRON;
 #elif USE_SYNC == 3
 	typedef SynchrotronComponentFList<16> SYNCHROTRON;
+	typedef SynchrotronComponentFList<16, OrPolicy, StdMutexLock, ArenaAllocator<void*>, ExternalState> ARENA_SYNCHROTRON;
 #elif USE_SYNC == 4
 	typedef SynchrotronComponentVector<16> SYNCHROTRON;
+	typedef SynchrotronComponentVector<16, OrPolicy, StdMutexLock, ArenaAllocator<void*>, ExternalState> ARENA_SYNCHROTRON;
 #elif USE_SYNC == 5
 	typedef SynchrotronComponentSetInsertEnd<16> SYNCHROTRON;
+	typedef SynchrotronComponentSetInsertEnd<16, OrPolicy, StdMutexLock, ArenaAllocator<void*>, ExternalState> ARENA_SYNCHROTRON;
 #elif USE_SYNC == 6
 	typedef SynchrotronComponentSetSort<16> SYNCHROTRON;
+	typedef SynchrotronComponentSetSort<16, OrPolicy, StdMutexLock, ArenaAllocator<void*>, ExternalState> ARENA_SYNCHROTRON;
+#elif USE_SYNC == 7
+	typedef SynchrotronComponentSmallSet<16> SYNCHROTRON;
+	typedef SynchrotronComponentSmallSet<16, OrPolicy, StdMutexLock, 4, ArenaAllocator<void*>, ExternalState> ARENA_SYNCHROTRON;
+#elif USE_SYNC == 8
+	typedef SynchrotronComponentFlatHash<16> SYNCHROTRON;
+	typedef SynchrotronComponentFlatHash<16, OrPolicy, StdMutexLock, ArenaAllocator<void*>, ExternalState> ARENA_SYNCHROTRON;
+#elif USE_SYNC == 9
+	typedef SynchrotronComponentRcu<16> SYNCHROTRON;
+	typedef SynchrotronComponentRcu<16, OrPolicy, StdMutexLock, ExternalState> ARENA_SYNCHROTRON;
 #endif
 
-void printResults(std::vector<size_t>& v) {
-	size_t min = 1e6, max = 0, sum = 0, size = v.size();
-	for(size_t i = 0; i < size; i++) {
-		if (v.at(i) < min) min = v.at(i);
-		if (v.at(i) > max) max = v.at(i);
-		sum += v.at(i);
+/**	\brief	Whether memoryUsage() of a Component with a CountingAllocator matches what that allocator counted.
+ */
+template <class COUNTED>
+bool memoryUsageMatchesCounted() {
+	const size_t before = CountingAllocator<void*>::getAllocatedBytes();
+	bool matches = true;
+	{
+		COUNTED source, outputs[8];
+
+		for(auto& output : outputs)
+			source.addOutput(output);
+
+		size_t total = source.memoryUsage() - sizeof(COUNTED);
+		for(auto& output : outputs)
+			total += output.memoryUsage() - sizeof(COUNTED);
+
+		matches = total == CountingAllocator<void*>::getAllocatedBytes() - before;
 	}
 
-	printf("Average time: %4d milliseconds :: (min= %4d, max= %4d)\n", (sum / size), min, max);
+	return matches && CountingAllocator<void*>::getAllocatedBytes() == before;
+}
+
+/**	\brief	Gets the state a gate with Policy ticks to, over inputs of 1100, 1010 and 1110.
+ */
+template <class Policy>
+std::bitset<4> combined() {
+	SynchrotronComponentSetSort<4, Policy> a(12), b(10), c(14), gate;
+
+	for(auto input : {&a, &b, &c})
+		input->addOutput(gate);
+
+	gate.tick();
+
+	return gate.getState();
+}
+
+/**	\brief	Gets how many inputs Policy reads before it stops at its saturation, over inputs of 0000, 1111 and 1111.
+ */
+template <class Policy>
+size_t readBeforeSaturation() {
+	std::vector<std::bitset<4>> inputs = {std::bitset<4>(0), std::bitset<4>(15), std::bitset<4>(15)};
+	size_t reads = 0;
+
+	Policy::reduce(std::bitset<4>(), inputs.begin(), inputs.end(), [&](const std::bitset<4>& in) -> const std::bitset<4>& { ++reads; return in; });
+
+	return reads;
+}
+
+/**	\brief	Inverts its inputs, only re-implementing evaluate(), so emit() has to reach it through tick().
+ */
+class NotGate : public SYNCHROTRON {
+	public:
+		virtual std::bitset<16> evaluate() const override {
+			std::bitset<16> inputs;
+
+			for(auto input : this->getInputs())
+				inputs |= input->getState();
+
+			return ~inputs;
+		}
+};
+
+class CountingGate : public SYNCHROTRON {
+	public:
+		size_t ticks = 0;
+
+		using SYNCHROTRON::SYNCHROTRON;
+		using SYNCHROTRON::tick;
+
+		virtual void tick() override {
+			++this->ticks;
+			SYNCHROTRON::tick();
+		}
+};
+
+template <class Scheduler>
+std::string tickedThrough(Scheduler& scheduler) {
+	CountingGate g1(4), g2(1), g3;
+
+	g1.addOutput(g2);
+	g2.addOutput(g3);
+	scheduler.emit(g1);
+	scheduler.run();
+
+	return g3.getState().to_string().substr(12) + " " + std::to_string(g2.ticks) + std::to_string(g3.ticks);
 }
 
 int main() {
-#ifndef TEST_PERFORMANCE
 	SYNCHROTRON slot(1);
 	SYNCHROTRON signal(2);
 
@@ -155,63 +235,314 @@ int main() {
     signal.emit();
 	std::cout << "state: " << s1.getState() << " Expected: " << "1010" << std::endl;
 
-#else
-	std::cout << "Starting tests...\n";
-	std::vector<size_t> runtimes_addOutputs, runtimes_Emit, runtimes_removeOutputs;
+	NotGate inverter;
+	signal.addOutput(inverter);
+	signal.emit();
+	std::cout << "Derived on emit: " << inverter.getState() << " Expected: " << "1111111111111101" << std::endl;
+
+	Incremental<SYNCHROTRON> merging;
+	SYNCHROTRON i1(1), i2(2);
+	merging.addInput({&i1, &i2});
+	merging.tick();
+	i2.setState(4);
+	i2.emit();
+	std::cout << "Incremental state: " << merging.getState() << " Expected: " << "0111" << std::endl;
+
+	Scheduler<SYNCHROTRON> scheduler;
+	SYNCHROTRON c1(4), c2(1), c3;
+
+	c1.addOutput(c2);
+	c2.addOutput(c3);
+	scheduler.emit(c1);
+	std::cout << "Scheduler updates: " << scheduler.run() << " Expected: " << 2 << std::endl;
+	std::cout << "Scheduler state: " << c3.getState() << " Expected: " << "0101" << std::endl;
+
+	Scheduler<CountingGate> tickScheduler;
+	std::cout << "Scheduler re-implemented tick(): " << tickedThrough(tickScheduler) << " Expected: " << "0101 11" << std::endl;
+
+	Scheduler<Incremental<SYNCHROTRON>> incrementalScheduler;
+	Incremental<SYNCHROTRON> merged1(4), merged2(1);
+	merged1.addOutput(merged2);
+	incrementalScheduler.emit(merged1);
+	incrementalScheduler.run();
+	std::cout << "Scheduler Incremental: " << merged2.getState() << " Expected: " << "0000000000000101" << std::endl;
+
+	SYNCHROTRON c4(8);
+	c4.addOutput(c3);
+
+	CompiledNetlist<SYNCHROTRON> compiled({&c1});
+	compiled.cycle();
+	std::cout << "Compiled levels: " << compiled.getLevelCount() << " Expected: " << 3 << std::endl;
+	std::cout << "Compiled state: " << c3.getState() << " Expected: " << "1101" << std::endl;
+
+	SYNCHROTRON c5(16);
+	c5.addOutput(c4);
+
+	FrozenNetlist<SYNCHROTRON> frozen({&c5});
+	frozen.emit(frozen.indexOf(c5));
+	frozen.store();
+	std::cout << "Frozen edges: " << frozen.getEdgeCount() << " Expected: " << 4 << std::endl;
+	std::cout << "Frozen state: " << c3.getState() << " Expected: " << "11101" << std::endl;
+
+	// 20 Components fit in a uint8_t index, their 380 edges don't
+	std::vector<SYNCHROTRON> clique(20);
+	std::vector<SYNCHROTRON*> root = {&clique[0]};
+	FrozenNetlist<SYNCHROTRON, uint8_t> narrow;
+	bool overflowed = false;
+
+	for(auto& from : clique) {
+		for(auto& to : clique) {
+			if (&from != &to) from.addOutput(to);
+		}
+	}
 
-	SYNCHROTRON				 	signalprovider(0x8000);
-	std::vector<SYNCHROTRON*>	slots;
+	try {
+		narrow.freeze(root.begin(), root.end());
+	} catch (const std::length_error&) {
+		overflowed = true;
+	}
 
-	for (int i = ELEMENTS; i--;) {
-		slots.push_back(new SYNCHROTRON(i % 0xFFFF));
+	std::cout << "Frozen index overflow: " << BSTR(overflowed && narrow.size() == 0) << std::endl;
+
+	Netlist<ARENA_SYNCHROTRON> netlist;
+	ARENA_SYNCHROTRON& n1 = netlist.create(2);
+	ARENA_SYNCHROTRON& n2 = netlist.create(1);
+
+	n1.addOutput(n2);
+	n1.emit();
+	std::cout << "Netlist state: " << n2.getState() << " Expected: " << "0011" << std::endl;
+	std::cout << "Netlist in arena: " << BSTR(netlist.getArena().getUsedBytes() >= 2 * sizeof(ARENA_SYNCHROTRON)) << std::endl;
+
+	std::vector<Netlist<ARENA_SYNCHROTRON>::state_type> snapshot;
+	netlist.getStates().snapshot(snapshot);
+	n1.setState(8);
+	std::cout << "Netlist states: " << netlist.getStates()[1] << " Expected: " << "0011" << std::endl;
+	std::cout << "Netlist states changed: " << netlist.getStates().diff(snapshot) << " Expected: " << 1 << std::endl;
+	std::cout << "Netlist state not inline: " << BSTR(sizeof(SynchrotronComponentSetSort<4096, OrPolicy, StdMutexLock, std::allocator<void*>, ExternalState>)
+													 < sizeof(SynchrotronComponentSetSort<4096>)) << std::endl;
+
+	std::bitset<16> externalState;
+	ARENA_SYNCHROTRON external(externalState, 4);
+	external.addOutput(n1);
+	netlist.clear();
+	std::cout << "Netlist size: " << netlist.size() << " Expected: " << 0 << std::endl;
+	std::cout << "Netlist disconnected external: " << BSTR(external.getOutputs().empty()) << std::endl;
+
+	TopologyBuilder<SYNCHROTRON> builder;
+	SYNCHROTRON t1(1), t2(2), t3, t4;
+	std::vector<SYNCHROTRON*> targets = {&t3, &t4};
+
+	builder.fanOut(t1, targets.begin(), targets.end());
+	builder.connect(t2, t3);
+	builder.connect(t2, t3);
+	builder.connect(t1, t4);
+	std::cout << "Topology edges: " << builder.commit() << " Expected: " << 3 << std::endl;
+	t1.emit();
+	t2.emit();
+	std::cout << "Topology state: " << t3.getState() << " Expected: " << "0011" << std::endl;
+
+	SYNCHROTRON r1, r2, r3;
+	r1.addOutput({&r2, &r3, &r2});
+	std::cout << "Range duplicates: " << std::distance(r1.getOutputs().begin(), r1.getOutputs().end()) << " Expected: " << 2 << std::endl;
+
+	Netlist<SYNCHROTRON> wide;
+	std::vector<SYNCHROTRON*> layer;
+
+	for(size_t i = 0; i < 64; i++)
+		layer.push_back(&wide.create(1 << (i % 16)));
+
+	for(size_t l = 0; l < 4; l++) {
+		std::vector<SYNCHROTRON*> next;
+
+		for(size_t i = 0; i < layer.size(); i++) {
+			next.push_back(&wide.create());
+			layer[i]->addOutput(*next.back());
+			layer[(i * 7 + 3) % layer.size()]->addOutput(*next.back());
+		}
+
+		layer.swap(next);
 	}
 
-	auto start = std::chrono::high_resolution_clock::now();
+	ThreadPool pool(4);
+	CompiledNetlist<SYNCHROTRON> serial(wide.getComponents().begin(), wide.getComponents().end());
+	CompiledNetlist<SYNCHROTRON> parallel(wide.getComponents().begin(), wide.getComponents().end());
 
-	for (int i = TIMES; i--;) {
-	////////////////////////////////////////////////////////////////////////////////
-		auto t1 = std::chrono::high_resolution_clock::now();
+	serial.evaluate();
+	parallel.evaluate(pool, 1);
+	std::cout << "Parallel levels: " << parallel.getLevelCount() << " Expected: " << 5 << std::endl;
+	std::cout << "Parallel matches serial: " << BSTR(parallel.getStates() == serial.getStates()) << std::endl;
 
-		for(auto& s : slots)
-			signalprovider.addOutput(*s);
+	ParallelScheduler<SYNCHROTRON> parallelScheduler(pool);
+	bool settled = true;
 
-		auto t2 = std::chrono::high_resolution_clock::now();
-		runtimes_addOutputs.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(t2-t1).count());
-	////////////////////////////////////////////////////////////////////////////////
-	std::cout << "Total Size    :: " << (sizeof(signalprovider) + 10000*sizeof(SYNCHROTRON)) << std::endl;
-	////////////////////////////////////////////////////////////////////////////////
-		t1 = std::chrono::high_resolution_clock::now();
+	for(size_t i = 0; i < 64; i++)
+		parallelScheduler.emit(*wide.getComponents()[i]);
 
-		signalprovider.emit();
+	parallelScheduler.run();
 
-		t2 = std::chrono::high_resolution_clock::now();
-		runtimes_Emit.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(t2-t1).count());
-	////////////////////////////////////////////////////////////////////////////////
-	////////////////////////////////////////////////////////////////////////////////
-		t1 = std::chrono::high_resolution_clock::now();
+	for(size_t i = 0; i < serial.getComponents().size(); i++)
+		settled = settled && serial.getComponents()[i]->getState() == serial.getStates()[i];
 
-		for(auto& s : slots)
-			signalprovider.removeOutput(*s);
+	std::cout << "ParallelScheduler matches serial: " << BSTR(settled && parallelScheduler.empty()) << std::endl;
 
-		t2 = std::chrono::high_resolution_clock::now();
-		runtimes_removeOutputs.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(t2-t1).count());
-	////////////////////////////////////////////////////////////////////////////////
-	}
+	ParallelScheduler<CountingGate> tickParallel(pool);
+	std::cout << "ParallelScheduler re-implemented tick(): " << tickedThrough(tickParallel) << " Expected: " << "0101 11" << std::endl;
+
+	ParallelScheduler<Incremental<SYNCHROTRON>> incrementalParallel(pool);
+	Incremental<SYNCHROTRON> merged3(4), merged4(1);
+	merged3.addOutput(merged4);
+	incrementalParallel.emit(merged3);
+	incrementalParallel.run();
+	std::cout << "ParallelScheduler Incremental: " << merged4.getState() << " Expected: " << "0000000000000101" << std::endl;
+
+	InboxComponent<SYNCHROTRON> inboxed;
+	SYNCHROTRON producer1(1), producer2(4), consumer;
+
+	producer1.addOutput(inboxed);
+	producer2.addOutput(inboxed);
+	inboxed.addOutput(consumer);
+
+	std::thread producer([&]() { producer1.emit(); });
+	producer2.emit();
+	producer.join();
+
+	std::cout << "Inbox queued: " << inboxed.getState() << " Expected: " << "0000" << std::endl;
+	std::cout << "Inbox drained: " << inboxed.drain() << " Expected: " << 2 << std::endl;
+	std::cout << "Inbox state: " << consumer.getState() << " Expected: " << "0101" << std::endl;
+
+	InboxComponent<SynchrotronComponentSetSort<4, AndPolicy>> andInbox;
+	SynchrotronComponentSetSort<4, AndPolicy> andProducer1(6), andProducer2(3);
+
+	andProducer1.addOutput(andInbox);
+	andProducer2.addOutput(andInbox);
+
+	std::thread andProducer([&]() { andProducer1.emit(); });
+	andProducer2.emit();
+	andProducer.join();
+
+	andInbox.drain();
+	std::cout << "Inbox snapshots: " << andInbox.getState() << " Expected: " << "0010" << std::endl;
+
+	SYNCHROTRON k1(1), k2, k3;
+	k1.addOutput(k2);
+	k2.addOutput(k3);
+
+	ClockedNetlist<SYNCHROTRON> clocked({&k1});
+	clocked.step(pool);
+	std::cout << "Clocked step: " << k2.getState() << k3.getState() << " Expected: " << "00000000000000010000000000000000" << std::endl;
+	std::cout << "Clocked steps: " << clocked.run() << " Expected: " << 2 << std::endl;
+	std::cout << "Clocked state: " << k3.getState() << " Expected: " << "0001" << std::endl;
+
+	Netlist<SYNCHROTRON> generated;
+	std::vector<SYNCHROTRON*> chain = Generators::chain(generated, 100, 5);
+	chain.front()->emit();
+	std::cout << "Generated chain: " << chain.back()->getState() << " Expected: " << "0101" << std::endl;
 
-	auto end = std::chrono::high_resolution_clock::now();
+	std::vector<SYNCHROTRON*> tree = Generators::tree(generated, 3, 4, 6);
+	tree.front()->emit();
+	std::cout << "Generated tree size: " << tree.size() << " Expected: " << 121 << std::endl;
+	std::cout << "Generated tree leaf: " << tree.back()->getState() << " Expected: " << "0110" << std::endl;
 
+	std::vector<SYNCHROTRON*> mesh = Generators::mesh(generated, 10, 10, 9);
+	mesh.front()->emit();
+	std::cout << "Generated mesh corner: " << mesh.back()->getState() << " Expected: " << "1001" << std::endl;
 
-	std::cout << "Test addOutputs    :: ";
-	printResults(runtimes_addOutputs);
-	std::cout << "Test emit          :: ";
-	printResults(runtimes_Emit);
-	std::cout << "Test removeOutputs :: ";
-	printResults(runtimes_removeOutputs);
-	std::cout << "Total time taken  :: " << std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count() << " milliseconds" << std::endl;
+	std::mt19937 random(7);
+	std::vector<SYNCHROTRON*> dag = Generators::randomDag(generated, 200, 0.05, random);
+	size_t dagEdges = 0;
+
+	for(auto node : dag)
+		dagEdges += std::distance(node->getOutputs().begin(), node->getOutputs().end());
+
+	std::cout << "Generated DAG edges ~" << 0.05 * 200 * 199 / 2 << ": " << BSTR(dagEdges > 800 && dagEdges < 1200) << std::endl;
+
+	std::vector<SYNCHROTRON*> ring = Generators::ring(generated, 4);
+	ClockedNetlist<SYNCHROTRON> ringClock(ring.begin(), ring.end());
+	std::cout << "Generated ring steps: " << ringClock.run() << " Expected: " << 4 << std::endl;
+	std::cout << "Generated ring state: " << ring.back()->getState() << " Expected: " << "0001" << std::endl;
+
+	SYNCHROTRON m1, m2[8];
+	const size_t alone = m1.memoryUsage();
+
+	for(auto& m : m2)
+		m1.addOutput(m);
+
+	std::cout << "Memory of outputs counted: " << BSTR(m1.memoryUsage() > alone && alone >= sizeof(SYNCHROTRON)) << std::endl;
+	std::cout << "Memory of netlist counted: " << BSTR(generated.memoryUsage() > generated.size() * sizeof(SYNCHROTRON)) << std::endl;
+	const bool counted =
+		memoryUsageMatchesCounted<SynchrotronComponentSetSort<16, OrPolicy, StdMutexLock, CountingAllocator<void*>>>() &&
+		memoryUsageMatchesCounted<SynchrotronComponentList<16, OrPolicy, StdMutexLock, CountingAllocator<void*>>>() &&
+		memoryUsageMatchesCounted<SynchrotronComponentVector<16, OrPolicy, StdMutexLock, CountingAllocator<void*>>>() &&
+		memoryUsageMatchesCounted<SynchrotronComponentSmallSet<16, OrPolicy, StdMutexLock, 4, CountingAllocator<void*>>>() &&
+		memoryUsageMatchesCounted<SynchrotronComponentFlatHash<16, OrPolicy, StdMutexLock, CountingAllocator<void*>>>();
+	std::cout << "Memory matches counting allocator: " << BSTR(counted) << std::endl;
+
+#ifdef SYNCHROTRON_STATS
+	Stats::reset();
+
+	SYNCHROTRON st1(1), st2, st3;
+	st1.addOutput(st2);
+	st2.addOutput(st3);
+	st1.emit();
+	st1.emit();
+
+	const Stats::Totals totals = Stats::collect();
+	std::cout << "Stats emits: " << totals.emits << " Expected: " << 4 << std::endl;
+	std::cout << "Stats ticks: " << totals.ticks << " Expected: " << 3 << std::endl;
+	std::cout << "Stats unchanged ticks: " << totals.unchangedTicks << " Expected: " << 1 << std::endl;
+	std::cout << "Stats max depth: " << totals.maxDepth << " Expected: " << 3 << std::endl;
+#endif
+
+#ifdef SYNCHROTRON_TRACE
+	std::vector<Trace::Event> traced = Trace::collect();
+	const uint64_t traceStart = traced.empty() ? 0 : traced.back().time;
+
+	SYNCHROTRON tr1(1), tr2, tr3;
+	tr1.addOutput(tr2);
+	tr2.addOutput(tr3);
+	tr1.emit();
+	tr1.emit();
+
+	traced = Trace::collect();
+	traced.erase(traced.begin(), std::find_if(traced.begin(), traced.end(), [&](const Trace::Event& e) { return e.time > traceStart; }));
+
+	std::cout << "Trace events: " << traced.size() << " Expected: " << 2 << std::endl;
+	std::cout << "Trace transitions: " << BSTR(traced.size() == 2 &&
+		traced[0].id == tr2.getId() && traced[0].before == 0 && traced[0].after == 1 &&
+		traced[1].id == tr3.getId() && traced[1].before == 0 && traced[1].after == 1) << " Expected: true" << std::endl;
+
+	std::bitset<128> wideBefore, wideAfter;
+	wideAfter.set(100);
+	Trace::record(tr3.getId(), wideBefore, wideAfter);
+
+	traced = Trace::collect();
+	std::cout << "Trace wide change: " << BSTR(!traced.empty() && traced.back().before == traced.back().after &&
+		traced.back().beforeHash != traced.back().afterHash) << " Expected: true" << std::endl;
+#endif
 
-	for(auto& s : slots) delete s;
-	slots.clear();
-#endif // TEST_PERFORMANCE
+	std::cout << "And: "      << combined<AndPolicy>()      << " Expected: " << "1000" << std::endl;
+	std::cout << "Nand: "     << combined<NandPolicy>()     << " Expected: " << "0111" << std::endl;
+	std::cout << "Xor: "      << combined<XorPolicy>()      << " Expected: " << "1000" << std::endl;
+	std::cout << "Majority: " << combined<MajorityPolicy>() << " Expected: " << "1110" << std::endl;
+	std::cout << "And saturated after: " << readBeforeSaturation<AndPolicy>() << " Expected: " << 1 << std::endl;
+	std::cout << "Or saturated after: "  << readBeforeSaturation<OrPolicy>()  << " Expected: " << 2 << std::endl;
+	std::cout << "Xor saturated after: " << readBeforeSaturation<XorPolicy>() << " Expected: " << 3 << std::endl;
+
+	std::vector<std::bitset<1024>> wideInputs(20);
+
+	for(size_t i = 0; i < wideInputs.size(); i++)
+		wideInputs[i].set(i * 37 % 1024).set((i * 101 + 5) % 1024).set(1023 - i);
+
+	auto byReference = [](const std::bitset<1024>& b) -> const std::bitset<1024>& { return b; };
+	auto byValue	 = [](const std::bitset<1024>& b) { return b; };
+
+	std::cout << "SIMD " << Simd::getKernelName() << " matches scalar: " << BSTR(
+		OrPolicy::reduce(wideInputs[0], wideInputs.begin(), wideInputs.end(), byReference) ==
+		OrPolicy::reduce(wideInputs[0], wideInputs.begin(), wideInputs.end(), byValue) &&
+		XorPolicy::reduce(wideInputs[0], wideInputs.begin(), wideInputs.end(), byReference) ==
+		XorPolicy::reduce(wideInputs[0], wideInputs.begin(), wideInputs.end(), byValue) &&
+		NandPolicy::reduce(wideInputs[0], wideInputs.begin(), wideInputs.begin() + 3, byReference) ==
+		NandPolicy::reduce(wideInputs[0], wideInputs.begin(), wideInputs.begin() + 3, byValue)) << std::endl;
 
 	return 0;
 }